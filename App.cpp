@@ -2,7 +2,15 @@
 //
 
 #include "framework.h"
+#include <thread>
+#include <atomic>
 #include "Engine.h"
+#include "SceneBuilder.h"
+#include "Renderer.h"
+#include "FixedTimestep.h"
+#include "FramePacer.h"
+#include "TripleBuffer.h"
+#include "SpscQueue.h"
 #include "App.h"
 
 #pragma comment(lib, "d2d1")
@@ -29,14 +37,38 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance
 }
 
 
-MainApp::MainApp() : m_hwnd(NULL)
+MainApp::MainApp() :
+    m_hwnd(NULL),
+    pacer(&clock, TARGET_FRAME_RATE),
+    minimized(false),
+    simulationStopping(false),
+    timestep(SIMULATION_TICK_RATE, MAX_CATCH_UP_STEPS)
 {
-    engine = new Engine();
+    pacer.SetUnfocusedFrameRate(UNFOCUSED_FRAME_RATE);
+    pacer.SetIdleFrameRate(IDLE_FRAME_RATE);
+
+    EngineConfig config;
+    config.tickTime = 1.0 / SIMULATION_TICK_RATE;
+    engine = new Engine(config);
+    renderer = new Renderer();
+
+    // Start the game again now that it's being recorded
+    recording.Start(timestep.GetTickTime());
+    engine->SetInputRecording(&recording);
+    engine->NewGame(engine->GetSeed());
+
+    // Tracing is cheap enough to leave on, so a slow frame can be looked at right after it happened
+    Trace::SetEnabled(true);
 }
 
 
 MainApp::~MainApp()
 {
+    recording.Finish(engine->GetTick());
+    recording.SaveToFile(SESSION_RECORDING_FILE);
+
+    delete renderer;
+    delete engine;
 }
 
 
@@ -44,6 +76,9 @@ void MainApp::RunMessageLoop()
 {
     MSG msg;
 
+    // The logic runs on its own thread from now on, this one only handles the window and draws
+    simulationThread = std::thread(&MainApp::SimulationLoop, this);
+
     std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
     std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
     int frames = 0;
@@ -52,6 +87,7 @@ void MainApp::RunMessageLoop()
     boolean running = true;
     while (running) 
     {
+        TRACE_SCOPE("Frame");
 
         end = std::chrono::steady_clock::now();
         double elapsed_secs = std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() / 1000000.0;
@@ -69,20 +105,113 @@ void MainApp::RunMessageLoop()
         }
 
         // Messages and user input
-        while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
         {
-            TranslateMessage(&msg);
-            DispatchMessage(&msg);
-            if (msg.message == WM_QUIT)
-                running = false;
+            TRACE_SCOPE("MessagePump");
+            while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
+            {
+                TranslateMessage(&msg);
+                DispatchMessage(&msg);
+                if (msg.message == WM_QUIT)
+                    running = false;
+            }
         }
 
-        // Game logic
-        engine->Logic(elapsed_secs);
+        // The newest snapshot the simulation published. If none came in since the last frame, we draw the same one again
+        snapshots.Update();
+        RenderSnapshot* snapshot = &snapshots.GetReadBuffer();
+
+        // Drawing, between the snapshot's tick and the next one. Nobody can see a minimized window
+        if (!minimized)
+        {
+            double alpha = 0;
+            if (snapshot->tickTime > 0)
+            {
+                alpha = (clock.Now() - snapshot->publishTime) / 1000000000.0 / snapshot->tickTime;
+                alpha = alpha < 0 ? 0 : (alpha > 1 ? 1 : alpha);
+            }
+            scene.Build(snapshot, alpha, &commands);
+            renderer->Submit(&commands);
+        }
 
-        // Drawing
-        engine->Draw();
+        // Wait for the next frame instead of spinning through the loop
+        pacer.SetIdle(minimized || snapshot->gameOver);
+        {
+            TRACE_SCOPE("Wait");
+            pacer.WaitForNextFrame();
+        }
     }
+
+    simulationStopping.store(true);
+    simulationThread.join();
+}
+
+void MainApp::SimulationLoop()
+{
+    // Wakes up once per tick. FixedTimestep still decides how many ticks to run, so late wake-ups are caught up
+    SystemClock simulationClock;
+    FramePacer tickPacer(&simulationClock, SIMULATION_TICK_RATE);
+    long long last = simulationClock.Now();
+
+    PublishSnapshot();
+    while (!simulationStopping.load())
+    {
+        long long now = simulationClock.Now();
+        int steps = timestep.Advance((now - last) / 1000000000.0);
+        last = now;
+
+        if (steps > 0)
+        {
+            // The ticks we run now cover the time up to now, minus what's left over for the next ones.
+            // Each key change goes into the tick it happened in, at the point of the tick it happened
+            long long tickLength = (long long)(timestep.GetTickTime() * 1000000000.0);
+            long long end = now - (long long)(timestep.GetAlpha() * tickLength);
+            for (int i = 0; i < steps; i++)
+            {
+                ApplyInput(end - (long long)(steps - i) * tickLength, tickLength);
+                engine->Logic(timestep.GetTickTime());
+            }
+            PublishSnapshot();
+        }
+
+        TRACE_SCOPE("SimulationWait");
+        tickPacer.WaitForNextFrame();
+    }
+}
+
+void MainApp::QueueKey(unsigned int key, bool pressed)
+{
+    InputEvent event;
+    event.time = clock.Now();
+    event.key = key;
+    event.pressed = pressed;
+
+    // If the simulation is stuck for long enough to fill the queue, the extra keys are lost
+    inputEvents.TryPush(event);
+}
+
+void MainApp::ApplyInput(long long tickStart, long long tickLength)
+{
+    const InputEvent* event;
+    while ((event = inputEvents.Front()) != NULL && event->time < tickStart + tickLength)
+    {
+        // Anything from before the tick (the first one, or after a hitch) counts from its start
+        double offset = event->time > tickStart ? (double)(event->time - tickStart) / tickLength : 0;
+        if (event->pressed)
+            engine->KeyDown(event->key, offset);
+        else
+            engine->KeyUp(event->key, offset);
+        inputEvents.Pop();
+    }
+}
+
+void MainApp::PublishSnapshot()
+{
+    TRACE_SCOPE("PublishSnapshot");
+    RenderSnapshot* snapshot = &snapshots.GetWriteBuffer();
+    engine->WriteSnapshot(snapshot);
+    snapshot->tickTime = timestep.GetTickTime();
+    snapshot->publishTime = clock.Now();
+    snapshots.Publish();
 }
 
 
@@ -122,7 +251,7 @@ HRESULT MainApp::Initialize()
     hr = m_hwnd ? S_OK : E_FAIL;
     if (SUCCEEDED(hr))
     {
-        engine->InitializeD2D(m_hwnd);
+        renderer->InitializeD2D(m_hwnd);
 
         ShowWindow(m_hwnd, SW_SHOWNORMAL);
         UpdateWindow(m_hwnd);
@@ -173,15 +302,36 @@ LRESULT CALLBACK MainApp::WndProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM
 
             case WM_KEYDOWN:
             {
-                pMainApp->engine->KeyDown(wParam);
+                if (wParam == VK_F9)
+                {
+                    Trace::ExportChromeJson(TRACE_EXPORT_FILE);
+                }
+                // Bit 30 is set on the repeats Windows sends while a key is held, the engine only needs the first one
+                if (!(lParam & (1 << 30)))
+                {
+                    pMainApp->QueueKey((unsigned int)wParam, true);
+                }
             }
             result = 0;
             wasHandled = true;
             break;
 
+            // Focus and minimizing only change the frame rate, Windows still handles them as usual
+            case WM_ACTIVATE:
+            {
+                pMainApp->pacer.SetFocused(LOWORD(wParam) != WA_INACTIVE);
+            }
+            break;
+
+            case WM_SIZE:
+            {
+                pMainApp->minimized = wParam == SIZE_MINIMIZED;
+            }
+            break;
+
             case WM_KEYUP:
             {
-                pMainApp->engine->KeyUp(wParam);
+                pMainApp->QueueKey((unsigned int)wParam, false);
             }
             result = 0;
             wasHandled = true;
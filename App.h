@@ -19,6 +19,30 @@ EXTERN_C IMAGE_DOS_HEADER __ImageBase;
 #endif
 
 
+// The game logic runs at this fixed rate, whatever the frame rate is
+#define SIMULATION_TICK_RATE 60
+// After a hitch, at most this many ticks are run in one frame to catch up
+#define MAX_CATCH_UP_STEPS 5
+// Every session's input is saved here on exit, so a bug can be replayed with asteroids_headless --replay
+#define SESSION_RECORDING_FILE "last_session.rec"
+// The main loop runs at this rate while the game has the focus, and slows down when it doesn't need it
+#define TARGET_FRAME_RATE 120
+#define UNFOCUSED_FRAME_RATE 30
+// Minimized, or nothing moving because the game is over
+#define IDLE_FRAME_RATE 10
+// Key presses waiting for the simulation thread. Far more than anybody can type between two ticks
+#define INPUT_QUEUE_CAPACITY 256
+// Pressing F9 writes the recent frames' timing spans here, open it in chrome://tracing or Perfetto
+#define TRACE_EXPORT_FILE "trace.json"
+
+// A key change from the window, with the time it happened, on its way to the simulation thread
+struct InputEvent
+{
+    long long time;
+    unsigned int key;
+    bool pressed;
+};
+
 class MainApp
 {
 public:
@@ -31,10 +55,32 @@ public:
     void RunMessageLoop();
 
 private:
+    // Runs the game logic on its own thread, in fixed ticks, and publishes a snapshot after each batch of ticks
+    void SimulationLoop();
+    void PublishSnapshot();
+    // Sends a key change from the window to the simulation thread
+    void QueueKey(unsigned int key, bool pressed);
+    // Gives the engine the key changes that happened before the end of the tick starting at tickStart
+    void ApplyInput(long long tickStart, long long tickLength);
 
     HWND m_hwnd;
 
     Engine* engine;
+    Renderer* renderer;
+    // What to draw each frame, rebuilt from the latest snapshot
+    SceneBuilder scene;
+    CommandList commands;
+    SystemClock clock;
+    FramePacer pacer;
+    bool minimized;
+    InputRecording recording;
+
+    // Simulation thread. The engine is only touched there: keys come in through the input queue, snapshots go out through the triple buffer
+    std::thread simulationThread;
+    std::atomic<bool> simulationStopping;
+    FixedTimestep timestep;
+    SpscQueue<InputEvent, INPUT_QUEUE_CAPACITY> inputEvents;
+    TripleBuffer<RenderSnapshot> snapshots;
 
     // The windows procedure.
     static LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
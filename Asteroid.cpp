@@ -1,175 +1,255 @@
-#include "framework.h"
+#include <math.h>
 #include "Point2D.h"
-#include "Engine.h"
+#include "World.h"
 #include "Asteroid.h"
 
-Asteroid::Asteroid() : m_pBlueBrush(NULL), m_pYellowBrush(NULL)
+AsteroidField::AsteroidField()
 {
+	// 6 big asteroids can end up as 24 small ones
+	store.Reserve(32);
+}
+
+AsteroidField::~AsteroidField()
+{
+}
+
+EntityHandle AsteroidField::Spawn(Random& random)
+{
+	EntityHandle handle = store.Add();
+	int index = store.Count() - 1;
+
 	// Initialize position randomly on the screen
-	position.x = rand() % RESOLUTION_X;
-	position.y = rand() % RESOLUTION_Y;
+	store.x[index] = random.NextInt(RESOLUTION_X);
+	store.y[index] = random.NextInt(RESOLUTION_Y);
 
 	// Initialize fixed speed in a random direction
-	double rotationAngle = rand() % 360;
-	speed.x = sin(rotationAngle * PI / 180) * ASTEROID_SPEED;
-	speed.y = -cos(rotationAngle * PI / 180) * ASTEROID_SPEED;
+	Scalar rotationAngle = random.NextInt(360);
+	store.speedX[index] = SinDegrees(rotationAngle) * ASTEROID_SPEED;
+	store.speedY[index] = -CosDegrees(rotationAngle) * ASTEROID_SPEED;
 
 	// Initial size : 4
-	size = 4;
+	InitializeShape(random, index, 4);
+	store.ResetPrevious(index);
 
-	// Initializes a random rotation speed
-	rotation = 0;
-	rotationSpeed = rand() % ASTEROID_MAX_ROTATION - (ASTEROID_MAX_ROTATION / 2);
-
-	// Generates random shape of the asteroid
-	int variation = ASTEROID_SIZE_VARIATION * size / 4;
-	for (int i = 0; i < ASTEROID_CORNERS; i++)
-	{
-		sizeVariation[i] = rand() % variation - (variation / 2.0);
-	}
+	return handle;
 }
 
-Asteroid::Asteroid(Point2D newPosition, int newSize, Point2D newSpeed) : m_pBlueBrush(NULL), m_pYellowBrush(NULL)
+EntityHandle AsteroidField::Spawn(Random& random, Point2D newPosition, int newSize, Point2D newSpeed)
 {
+	EntityHandle handle = store.Add();
+	int index = store.Count() - 1;
+
 	// Initializes position, speed and size from received parameters
-	position = newPosition;
-	speed = newSpeed;
-	size = newSize;
+	store.x[index] = ScalarFromDouble(newPosition.x);
+	store.y[index] = ScalarFromDouble(newPosition.y);
+	store.speedX[index] = ScalarFromDouble(newSpeed.x);
+	store.speedY[index] = ScalarFromDouble(newSpeed.y);
+
+	InitializeShape(random, index, newSize);
+	store.ResetPrevious(index);
+
+	return handle;
+}
+
+void AsteroidField::InitializeShape(Random& random, int index, int newSize)
+{
+	AsteroidShape& shape = store.payload[index];
+	shape.size = newSize;
 
 	// Initializes a random rotation speed
-	rotation = 0;
-	rotationSpeed = rand() % ASTEROID_MAX_ROTATION - (ASTEROID_MAX_ROTATION / 2);
+	store.rotation[index] = 0;
+	store.rotationSpeed[index] = random.NextInt(ASTEROID_MAX_ROTATION) - (ASTEROID_MAX_ROTATION / 2);
 
 	// Generates random shape of the asteroid
-	int variation = ASTEROID_SIZE_VARIATION * size / 4;
+	int variation = ASTEROID_SIZE_VARIATION * newSize / 4;
 	for (int i = 0; i < ASTEROID_CORNERS; i++)
 	{
-		sizeVariation[i] = rand() % variation - (variation / 2.0);
+		shape.sizeVariation[i] = random.NextInt(variation) - (variation / 2.0);
+	}
+
+	// Builds the outline from the shape, with the first corner pointing up.
+	// The corners are computed with the physics numbers, so fixed-point builds get the same outline everywhere
+	int angleStep = 360 / ASTEROID_CORNERS;
+	shape.outlineRadius = 0;
+	for (int i = 0; i < ASTEROID_CORNERS; i++)
+	{
+		Scalar cornerRadius = newSize * ASTEROID_SIZE_MULTIPLIER + shape.sizeVariation[i];
+		shape.outline[i].x = ScalarToDouble(cornerRadius * SinDegrees(i * angleStep));
+		shape.outline[i].y = ScalarToDouble(-cornerRadius * CosDegrees(i * angleStep));
+		if (ScalarToDouble(cornerRadius) > shape.outlineRadius)
+		{
+			shape.outlineRadius = ScalarToDouble(cornerRadius);
+		}
 	}
+
+	// The bounding circle for collisions
+	store.radius[index] = ScalarFromDouble(shape.outlineRadius);
 }
 
-Asteroid::~Asteroid()
+void AsteroidField::Remove(int index)
 {
-	SafeRelease(&m_pBlueBrush);
-	SafeRelease(&m_pYellowBrush);
+	store.Remove(index);
 }
 
-void Asteroid::InitializeD2D(ID2D1HwndRenderTarget* m_pRenderTarget)
+void AsteroidField::Clear()
 {
-	// Creates a blue brush for drawing asteroid
-	m_pRenderTarget->CreateSolidColorBrush(
-		D2D1::ColorF(D2D1::ColorF::Blue),
-		&m_pBlueBrush
-	);
-	// Creates a yellow brush for drawing explosions
-	m_pRenderTarget->CreateSolidColorBrush(
-		D2D1::ColorF(D2D1::ColorF::Yellow),
-		&m_pYellowBrush
-	);
+	store.Clear();
 }
 
-void Asteroid::Advance(double elapsedTime)
+void AsteroidField::SaveState(StateWriter& writer)
 {
-	// If size > 0, we have an asteroid moving around
-	// If size == 0, our asteroid is exploded
-	if (size > 0)
-	{
-		// We move it around, and if it goes outside the screen, we make it pop up on the other side
-		position.x += elapsedTime * speed.x;
-		if (position.x < -10)
-		{
-			position.x = RESOLUTION_X + 10;
-		}
-		if (position.x > RESOLUTION_X + 10)
-		{
-			position.x = -10;
-		}
-		position.y += elapsedTime * speed.y;
-		if (position.y < -10)
-		{
-			position.y = RESOLUTION_Y + 10;
-		}
-		if (position.y > RESOLUTION_Y + 10)
-		{
-			position.y = -10;
-		}
-		// We also rotate it
-		rotation += rotationSpeed * elapsedTime;
-	}
-	else
-	{
-		// We use explosionTime to generate a visual explosion and remove it after 0.5 seconds
-		explosionTime += elapsedTime;
-	}
+	store.SaveState(writer);
 }
 
-void Asteroid::Explode()
+void AsteroidField::LoadState(StateReader& reader)
 {
-	// Asteroids goes into explosion mode
-	size = 0;
-	explosionTime = 0;
+	store.LoadState(reader);
 }
 
-void Asteroid::Draw(ID2D1HwndRenderTarget* m_pRenderTarget)
+void AsteroidField::Advance(Scalar elapsedTime)
 {
-	if (size > 0)
-	{
-		// If it's not exploded, we draw the asteroid's shape
-		ID2D1PathGeometry* clPath;
-		ID2D1Factory* factory;
-		m_pRenderTarget->GetFactory(&factory);
-		factory->CreatePathGeometry(&clPath);
-
-		ID2D1GeometrySink* pclSink;
-		clPath->Open(&pclSink);
-		pclSink->SetFillMode(D2D1_FILL_MODE_WINDING);
-		D2D1_POINT_2F point0 = D2D1::Point2F(position.x + (size * ASTEROID_SIZE_MULTIPLIER + sizeVariation[0]) * sin(rotation * PI / 180), position.y - (size * ASTEROID_SIZE_MULTIPLIER + sizeVariation[0]) * cos(rotation * PI / 180));
-		pclSink->BeginFigure(point0, D2D1_FIGURE_BEGIN_FILLED);
-		int angleStep = 360 / ASTEROID_CORNERS;
-		for (int i = 1; i < ASTEROID_CORNERS; i++)
-		{
-			D2D1_POINT_2F point = D2D1::Point2F(position.x + (size * ASTEROID_SIZE_MULTIPLIER + sizeVariation[i]) * sin((rotation + i * angleStep) * PI / 180), position.y - (size * ASTEROID_SIZE_MULTIPLIER + sizeVariation[i]) * cos((rotation + i * angleStep) * PI / 180));
-			pclSink->AddLine(point);
-		}
-		pclSink->EndFigure(D2D1_FIGURE_END_CLOSED);
-		pclSink->Close();
-		m_pRenderTarget->DrawGeometry(clPath, m_pBlueBrush, 4);
+	// Every asteroid moves, all at once.
+	// If an asteroid goes outside the screen, it pops up on the other side
+	store.Integrate(elapsedTime, true);
+}
 
-		SafeRelease(&pclSink);
-		SafeRelease(&clPath);
+int AsteroidField::GetCount()
+{
+	return store.Count();
+}
 
-	}
-	else
-	{
-		// In case of an explosion, we draw 9 points moving away from the center
-		int angleStep = 360 / ASTEROID_CORNERS;
-		for (int i = 0; i < ASTEROID_CORNERS; i++)
-		{
-			D2D1_ELLIPSE ellipseBall = D2D1::Ellipse(
-				D2D1::Point2F(position.x + (explosionTime * (100 + 20 * sizeVariation[i])) * sin(i * angleStep * PI / 180), position.y - (explosionTime * (100 + 20 * sizeVariation[i])) * cos(i * angleStep * PI / 180)),
-				4, 4
-			);
-			m_pRenderTarget->FillEllipse(&ellipseBall, m_pYellowBrush);
-		}
-	}
+EntityHandle AsteroidField::GetHandle(int index)
+{
+	return store.HandleOf(index);
+}
+
+int AsteroidField::Find(EntityHandle handle)
+{
+	return store.IndexOf(handle);
+}
+
+Point2D AsteroidField::GetPosition(int index)
+{
+	Point2D position;
+	position.x = ScalarToDouble(store.x[index]);
+	position.y = ScalarToDouble(store.y[index]);
+	return position;
+}
+
+Point2D AsteroidField::GetPreviousPosition(int index)
+{
+	Point2D position;
+	position.x = ScalarToDouble(store.previousX[index]);
+	position.y = ScalarToDouble(store.previousY[index]);
+	return position;
 }
 
-Point2D Asteroid::GetPosition()
+Point2D AsteroidField::GetInterpolatedPosition(int index, double alpha)
 {
+	Point2D position;
+	position.x = Interpolate(ScalarToDouble(store.previousX[index]), ScalarToDouble(store.x[index]), alpha);
+	position.y = Interpolate(ScalarToDouble(store.previousY[index]), ScalarToDouble(store.y[index]), alpha);
 	return position;
 }
 
-Point2D Asteroid::GetSpeed()
+Point2D AsteroidField::GetSpeed(int index)
 {
+	Point2D speed;
+	speed.x = ScalarToDouble(store.speedX[index]);
+	speed.y = ScalarToDouble(store.speedY[index]);
 	return speed;
 }
 
-int Asteroid::GetSize()
+int AsteroidField::GetSize(int index)
+{
+	return store.payload[index].size;
+}
+
+double AsteroidField::GetRotation(int index)
+{
+	return ScalarToDouble(store.rotation[index]);
+}
+
+double AsteroidField::GetInterpolatedRotation(int index, double alpha)
+{
+	return Interpolate(ScalarToDouble(store.previousRotation[index]), ScalarToDouble(store.rotation[index]), alpha);
+}
+
+int AsteroidField::GetSizeVariation(int index, int corner)
+{
+	return store.payload[index].sizeVariation[corner];
+}
+
+
+const Point2D* AsteroidField::GetOutline(int index)
+{
+	return store.payload[index].outline;
+}
+
+double AsteroidField::GetOutlineRadius(int index)
+{
+	return store.payload[index].outlineRadius;
+}
+
+CircleSet AsteroidField::GetCircles()
+{
+	CircleSet circles;
+	circles.x = store.x.data();
+	circles.y = store.y.data();
+	circles.radius = store.radius.data();
+	circles.previousX = store.previousX.data();
+	circles.previousY = store.previousY.data();
+	return circles;
+}
+
+void AsteroidField::ToOutlineSpace(int index, Scalar centerX, Scalar centerY, Scalar& x, Scalar& y)
+{
+	// The rotation during the tick is left out: it's under a degree at 60 ticks per second
+	Scalar s = SinDegrees(store.rotation[index]);
+	Scalar c = CosDegrees(store.rotation[index]);
+	Scalar dx = x - centerX;
+	Scalar dy = y - centerY;
+	x = dx * c + dy * s;
+	y = dy * c - dx * s;
+}
+
+void AsteroidField::GetOutline(int index, Scalar* outlineX, Scalar* outlineY)
+{
+	// The outline came from Scalars, so it converts back exactly
+	const Point2D* outline = store.payload[index].outline;
+	for (int i = 0; i < ASTEROID_CORNERS; i++)
+	{
+		outlineX[i] = ScalarFromDouble(outline[i].x);
+		outlineY[i] = ScalarFromDouble(outline[i].y);
+	}
+}
+
+Scalar AsteroidField::FirstContact(int index, Scalar startX, Scalar startY, Scalar endX, Scalar endY)
 {
-	return size;
+	ToOutlineSpace(index, store.previousX[index], store.previousY[index], startX, startY);
+	ToOutlineSpace(index, store.x[index], store.y[index], endX, endY);
+
+	Scalar outlineX[ASTEROID_CORNERS];
+	Scalar outlineY[ASTEROID_CORNERS];
+	GetOutline(index, outlineX, outlineY);
+	return FirstContactInOutline(outlineX, outlineY, ASTEROID_CORNERS, startX, startY, endX, endY);
 }
 
-double Asteroid::GetExplosionTime()
+bool AsteroidField::OverlapsTriangle(int index, Scalar time, const Scalar* triangleX, const Scalar* triangleY)
 {
-	return explosionTime;
-}
\ No newline at end of file
+	Scalar centerX = store.previousX[index] + (store.x[index] - store.previousX[index]) * time;
+	Scalar centerY = store.previousY[index] + (store.y[index] - store.previousY[index]) * time;
+	Scalar x[3];
+	Scalar y[3];
+	for (int i = 0; i < 3; i++)
+	{
+		x[i] = triangleX[i];
+		y[i] = triangleY[i];
+		ToOutlineSpace(index, centerX, centerY, x[i], y[i]);
+	}
+
+	Scalar outlineX[ASTEROID_CORNERS];
+	Scalar outlineY[ASTEROID_CORNERS];
+	GetOutline(index, outlineX, outlineY);
+	return TriangleOverlapsOutline(outlineX, outlineY, ASTEROID_CORNERS, x, y);
+}
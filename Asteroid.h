@@ -1,7 +1,9 @@
 #pragma once
 
-#include "resource.h"
 #include "Point2D.h"
+#include "EntityStore.h"
+#include "Random.h"
+#include "Narrowphase.h"
 
 #define ASTEROID_SPEED 50
 #define ASTEROID_MAX_ROTATION 90
@@ -9,36 +11,65 @@
 #define ASTEROID_SIZE_VARIATION 20
 #define ASTEROID_CORNERS 9
 
-class Asteroid
+// What makes each asteroid different, stored next to its common components
+struct AsteroidShape
 {
-public:
-	Asteroid();
-	Asteroid(Point2D newPosition, int newSize, Point2D newSpeed);
-	~Asteroid();
+	int size;
+	int sizeVariation[ASTEROID_CORNERS];
 
-	void InitializeD2D(ID2D1HwndRenderTarget* m_pRenderTarget);
-	void Advance(double elapsedTime);
-	void Explode();
+	// Corners of the asteroid relative to its center, before rotation.
+	// Computed once when the asteroid is created, then only rotated and moved when it's needed
+	Point2D outline[ASTEROID_CORNERS];
+	// Distance from the center to the farthest corner
+	double outlineRadius;
+};
+
+// All the asteroids in the game.
+// An asteroid is identified by its index, which stays the same until an asteroid is removed
+class AsteroidField
+{
+public:
+	AsteroidField();
+	~AsteroidField();
 
-	void Draw(ID2D1HwndRenderTarget* m_pRenderTarget);
+	EntityHandle Spawn(Random& random);
+	EntityHandle Spawn(Random& random, Point2D newPosition, int newSize, Point2D newSpeed);
+	void Remove(int index);
+	void Clear();
+	void SaveState(StateWriter& writer);
+	void LoadState(StateReader& reader);
+	void Advance(Scalar elapsedTime);
 
-	Point2D GetPosition();
-	Point2D GetSpeed();
-	int GetSize();
-	double GetExplosionTime();
+	int GetCount();
+	EntityHandle GetHandle(int index);
+	int Find(EntityHandle handle);
 
-private:
-	Point2D position;
-	Point2D speed;
+	Point2D GetPosition(int index);
+	// Where the asteroid was at the start of the tick, moved along if it wrapped around the screen
+	Point2D GetPreviousPosition(int index);
+	Point2D GetInterpolatedPosition(int index, double alpha);
+	Point2D GetSpeed(int index);
+	int GetSize(int index);
+	double GetRotation(int index);
+	double GetInterpolatedRotation(int index, double alpha);
+	int GetSizeVariation(int index, int corner);
+	const Point2D* GetOutline(int index);
+	double GetOutlineRadius(int index);
+	// Bounding circles of all the asteroids, indexed like the asteroids. Each one holds the whole outline
+	CircleSet GetCircles();
 
-	int size;
-	double explosionTime;
-	double rotation;
-	double rotationSpeed;
+	// Exact tests against the outline, for pairs whose bounding circles touch.
+	// When a point going from start (at the start of the tick) to end (at the end) first gets inside the outline, as a fraction of the tick, or -1.
+	// The asteroid moves during the tick too, so the path is taken relative to it
+	Scalar FirstContact(int index, Scalar startX, Scalar startY, Scalar endX, Scalar endY);
+	// True if the triangle overlaps the outline where the asteroid was at that time in the tick, from 0 at its start to 1 (now)
+	bool OverlapsTriangle(int index, Scalar time, const Scalar* triangleX, const Scalar* triangleY);
 
-	int sizeVariation[ASTEROID_CORNERS];
+private:
+	void InitializeShape(Random& random, int index, int newSize);
+	// Moves a point into the asteroid's own space: relative to the center (x, y), then turned back by the rotation
+	void ToOutlineSpace(int index, Scalar centerX, Scalar centerY, Scalar& x, Scalar& y);
+	void GetOutline(int index, Scalar* outlineX, Scalar* outlineY);
 
-	ID2D1SolidColorBrush* m_pBlueBrush;
-	ID2D1SolidColorBrush* m_pYellowBrush;
+	EntityStore<AsteroidShape> store;
 };
-
@@ -0,0 +1,146 @@
+#include <chrono>
+#include "BatchRunner.h"
+
+BatchRunner::BatchRunner(int engineCount, int threadCount, const EngineConfig& config) :
+    config(config), inputPolicy(NULL), pool(threadCount)
+{
+    for (int i = 0; i < engineCount; i++)
+    {
+        Instance* instance = new Instance();
+        instance->engine = new Engine(config);
+        instance->engine->NewGame(config.seed + i);
+        instance->gameTick = 0;
+        instance->gamesPlayed = 0;
+        instances.push_back(instance);
+    }
+}
+
+BatchRunner::~BatchRunner()
+{
+    for (size_t i = 0; i < instances.size(); i++)
+    {
+        delete instances[i]->engine;
+        delete instances[i];
+    }
+}
+
+void BatchRunner::SetInputPolicy(InputPolicy policy)
+{
+    inputPolicy = policy;
+}
+
+void BatchRunner::Step(Instance* instance, int index, double tickTime)
+{
+    Engine* engine = instance->engine;
+    if (inputPolicy != NULL)
+    {
+        inputPolicy(engine, instance->gameTick);
+    }
+    engine->Logic(tickTime);
+    instance->gameTick++;
+    instance->ticks++;
+
+    if (engine->IsGameOver())
+    {
+        if (engine->IsGameWon())
+            instance->gamesWon++;
+        else
+            instance->gamesLost++;
+
+        // Next game, with a seed no other engine uses
+        instance->gamesPlayed++;
+        engine->NewGame(config.seed + index + (uint64_t)instance->gamesPlayed * instances.size());
+        instance->gameTick = 0;
+    }
+}
+
+BatchResult BatchRunner::RunLockstep(long long ticks, double tickTime)
+{
+    for (size_t i = 0; i < instances.size(); i++)
+    {
+        instances[i]->ticks = 0;
+        instances[i]->gamesWon = 0;
+        instances[i]->gamesLost = 0;
+    }
+
+    // A few chunks per thread: big enough to make the per-tick handoff cheap, small enough to balance
+    int engineCount = (int)instances.size();
+    int chunkSize = engineCount / (pool.GetThreadCount() * 4);
+    if (chunkSize < 1)
+        chunkSize = 1;
+    int chunkCount = (engineCount + chunkSize - 1) / chunkSize;
+
+    std::function<void(int)> stepChunk = [this, chunkSize, engineCount, tickTime](int chunk)
+    {
+        int end = (chunk + 1) * chunkSize < engineCount ? (chunk + 1) * chunkSize : engineCount;
+        for (int i = chunk * chunkSize; i < end; i++)
+        {
+            Step(instances[i], i, tickTime);
+        }
+    };
+
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    for (long long tick = 0; tick < ticks; tick++)
+    {
+        pool.ParallelFor(chunkCount, stepChunk);
+    }
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+    return Collect(std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() / 1000000.0);
+}
+
+BatchResult BatchRunner::RunFree(long long ticks, double tickTime)
+{
+    for (size_t i = 0; i < instances.size(); i++)
+    {
+        instances[i]->ticks = 0;
+        instances[i]->gamesWon = 0;
+        instances[i]->gamesLost = 0;
+    }
+
+    std::function<void(int)> runEngine = [this, ticks, tickTime](int index)
+    {
+        Instance* instance = instances[index];
+        for (long long tick = 0; tick < ticks; tick++)
+        {
+            Step(instance, index, tickTime);
+        }
+    };
+
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    pool.ParallelFor((int)instances.size(), runEngine);
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+    return Collect(std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() / 1000000.0);
+}
+
+BatchResult BatchRunner::Collect(double seconds)
+{
+    BatchResult result;
+    result.ticks = 0;
+    result.gamesWon = 0;
+    result.gamesLost = 0;
+    result.seconds = seconds;
+    for (size_t i = 0; i < instances.size(); i++)
+    {
+        result.ticks += instances[i]->ticks;
+        result.gamesWon += instances[i]->gamesWon;
+        result.gamesLost += instances[i]->gamesLost;
+    }
+    return result;
+}
+
+int BatchRunner::GetEngineCount()
+{
+    return (int)instances.size();
+}
+
+int BatchRunner::GetThreadCount()
+{
+    return pool.GetThreadCount();
+}
+
+Engine* BatchRunner::GetEngine(int index)
+{
+    return instances[index]->engine;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+#include "Engine.h"
+#include "ThreadPool.h"
+
+// Input for one engine at one tick of its current game.
+// Called from the worker threads, so it must only touch the engine it's given
+typedef void (*InputPolicy)(Engine* engine, long long tick);
+
+struct BatchResult
+{
+	long long ticks;
+	int gamesWon;
+	int gamesLost;
+	double seconds;
+};
+
+// Owns many independent headless engines and runs them on all cores.
+// Engines share nothing, so the only synchronization is handing out the work.
+// When a game ends, its engine starts the next one right away with a new seed
+class BatchRunner
+{
+public:
+	// Engine i plays the seeds config.seed + i, config.seed + i + engineCount, ...
+	BatchRunner(int engineCount, int threadCount, const EngineConfig& config);
+	~BatchRunner();
+
+	void SetInputPolicy(InputPolicy policy);
+
+	// Every engine advances one tick, then the next tick starts. Each tick is spread over the threads
+	BatchResult RunLockstep(long long ticks, double tickTime);
+	// Every engine runs all its ticks on its own, the threads pick up engines as they become free
+	BatchResult RunFree(long long ticks, double tickTime);
+
+	int GetEngineCount();
+	int GetThreadCount();
+	Engine* GetEngine(int index);
+
+private:
+	// Everything one engine needs, on its own cache line so threads don't write to each other's
+	struct alignas(64) Instance
+	{
+		Engine* engine;
+		long long gameTick;
+		int gamesPlayed;
+		long long ticks;
+		int gamesWon;
+		int gamesLost;
+	};
+
+	void Step(Instance* instance, int index, double tickTime);
+	BatchResult Collect(double seconds);
+
+	EngineConfig config;
+	InputPolicy inputPolicy;
+	std::vector<Instance*> instances;
+	ThreadPool pool;
+};
@@ -0,0 +1,649 @@
+// Bench.cpp : Times Engine::Logic on scripted worlds, from the real game's 6 asteroids up to 100 000.
+// Also times building the frame's command list and walking it with the null backend.
+// Prints a table, or JSON with --json so results can be compared from one commit to the next
+//
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <new>
+#include <vector>
+#include "Engine.h"
+#include "Motion.h"
+#include "Narrowphase.h"
+#include "SceneBuilder.h"
+#include "RenderBackend.h"
+#include "VideoExporter.h"
+
+// Every allocation in the process goes through here, so we can tell how many happen during a tick
+static long long allocationCount = 0;
+
+void* operator new(size_t size)
+{
+    allocationCount++;
+    void* pointer = malloc(size ? size : 1);
+    if (pointer == NULL)
+    {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void operator delete(void* pointer) noexcept
+{
+    free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+    free(pointer);
+}
+
+// Each round starts again from the same world, and runs this many ticks
+#define TICKS_PER_ROUND 60
+
+static const int ASTEROID_COUNTS[] = { 6, 32, 1000, 100000 };
+static const int PROJECTILE_LOADS[] = { 0, 64, 1024 };
+
+struct Scenario
+{
+    int asteroids;
+    int projectiles;
+
+    long long ticks;
+    double nanosecondsPerTick;
+    double allocationsPerTick;
+    double averageAsteroids;
+    // Building the frame's command list and walking it with the null backend, without any actual drawing
+    double drawNanosecondsPerFrame;
+    double drawCommandsPerFrame;
+    double drawBatchesPerFrame;
+    EngineProfile profile;
+    // How the time grows with the asteroid count, since the previous scenario with the same projectiles (1 is linear)
+    double scalingExponent;
+};
+
+// Keeps the projectile load up, the ones that hit something or left the screen are replaced
+static void RefillProjectiles(ProjectileField* projectiles, int load, Random& random)
+{
+    while (projectiles->GetAliveCount() < load)
+    {
+        Point2D position;
+        position.x = random.NextInt(RESOLUTION_X);
+        position.y = random.NextInt(RESOLUTION_Y);
+        if (!projectiles->Spawn(position, random.NextInt(360)))
+        {
+            break;
+        }
+    }
+}
+
+// Fills the screen with asteroids of every size, moving in random directions
+static void BuildWorld(Engine* engine, int asteroidCount, Random& random)
+{
+    static const int sizes[] = { 1, 2, 4 };
+
+    AsteroidField* asteroids = engine->GetAsteroids();
+    asteroids->Clear();
+    for (int i = 0; i < asteroidCount; i++)
+    {
+        Point2D position;
+        position.x = random.NextInt(RESOLUTION_X);
+        position.y = random.NextInt(RESOLUTION_Y);
+        double angle = random.NextInt(360) * PI / 180;
+        Point2D speed;
+        speed.x = sin(angle) * ASTEROID_SPEED;
+        speed.y = -cos(angle) * ASTEROID_SPEED;
+        asteroids->Spawn(random, position, sizes[random.NextInt(3)], speed);
+    }
+}
+
+static void RunScenario(Scenario& scenario, double minSeconds, double tickTime)
+{
+    EngineConfig config;
+    config.maxProjectiles = scenario.projectiles > 0 ? scenario.projectiles : 1;
+    config.tickTime = tickTime;
+    Engine engine(config);
+
+    Random random(12345);
+    BuildWorld(&engine, scenario.asteroids, random);
+    std::vector<unsigned char> world(engine.GetStateSize());
+    engine.SaveState(world.data(), world.size());
+
+    RenderSnapshot snapshot;
+    SceneBuilder scene;
+    CommandList commands;
+    NullBackend backend;
+    long long drawNanoseconds = 0;
+
+    scenario.profile.Reset();
+    long long nanoseconds = 0;
+    long long allocations = 0;
+    long long asteroidTicks = 0;
+    scenario.ticks = 0;
+
+    // The first round only warms up the caches and lets the scratch buffers grow
+    for (int round = 0; round == 0 || round == 1 || nanoseconds < minSeconds * 1e9; round++)
+    {
+        bool measured = round > 0;
+        engine.LoadState(world.data(), world.size());
+        engine.SetProfile(measured ? &scenario.profile : NULL);
+        random.Seed(round);
+
+        for (int t = 0; t < TICKS_PER_ROUND; t++)
+        {
+            RefillProjectiles(engine.GetProjectiles(), scenario.projectiles, random);
+            asteroidTicks += measured ? engine.GetAsteroids()->GetCount() : 0;
+
+            long long allocationsBefore = allocationCount;
+            std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+            engine.Logic(tickTime);
+            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+            engine.WriteSnapshot(&snapshot);
+            std::chrono::steady_clock::time_point drawBegin = std::chrono::steady_clock::now();
+            scene.Build(&snapshot, 0.5, &commands);
+            backend.Submit(&commands);
+            std::chrono::steady_clock::time_point drawEnd = std::chrono::steady_clock::now();
+
+            if (measured)
+            {
+                nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+                drawNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(drawEnd - drawBegin).count();
+                allocations += allocationCount - allocationsBefore;
+                scenario.ticks++;
+            }
+        }
+    }
+
+    scenario.nanosecondsPerTick = (double)nanoseconds / scenario.ticks;
+    scenario.allocationsPerTick = (double)allocations / scenario.ticks;
+    scenario.averageAsteroids = (double)asteroidTicks / scenario.ticks;
+    scenario.drawNanosecondsPerFrame = (double)drawNanoseconds / scenario.ticks;
+    // The warm-up round went through the backend too
+    scenario.drawCommandsPerFrame = (double)backend.GetCommands() / backend.GetFrames();
+    scenario.drawBatchesPerFrame = (double)backend.GetBatches() / backend.GetFrames();
+}
+
+// Components of an entity store with random values, for running the motion kernel on its own
+struct MotionData
+{
+    std::vector<Scalar> arrays[10];
+
+    MotionData(int count, Random& random)
+    {
+        for (int a = 0; a < 10; a++)
+        {
+            arrays[a].resize(count);
+        }
+        for (int i = 0; i < count; i++)
+        {
+            // Positions cover a bit more than the screen and speeds are high, so plenty of entities wrap every tick
+            arrays[0][i] = ScalarFromDouble(random.NextInt(RESOLUTION_X + 40) - 20 + random.NextInt(1000) / 1000.0);
+            arrays[1][i] = ScalarFromDouble(random.NextInt(RESOLUTION_Y + 40) - 20 + random.NextInt(1000) / 1000.0);
+            arrays[2][i] = random.NextInt(360);
+            arrays[6][i] = ScalarFromDouble(random.NextInt(2001) - 1000 + random.NextInt(1000) / 1000.0);
+            arrays[7][i] = ScalarFromDouble(random.NextInt(2001) - 1000 + random.NextInt(1000) / 1000.0);
+            arrays[8][i] = random.NextInt(181) - 90;
+        }
+    }
+
+    MotionArrays GetArrays()
+    {
+        MotionArrays motion;
+        motion.x = arrays[0].data();
+        motion.y = arrays[1].data();
+        motion.rotation = arrays[2].data();
+        motion.previousX = arrays[3].data();
+        motion.previousY = arrays[4].data();
+        motion.previousRotation = arrays[5].data();
+        motion.speedX = arrays[6].data();
+        motion.speedY = arrays[7].data();
+        motion.rotationSpeed = arrays[8].data();
+        motion.age = arrays[9].data();
+        return motion;
+    }
+
+    bool operator==(const MotionData& other) const
+    {
+        for (int a = 0; a < 10; a++)
+        {
+            if (memcmp(arrays[a].data(), other.arrays[a].data(), arrays[a].size() * sizeof(Scalar)) != 0)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+static void PrintKernel(const char* kernel, int items, SimdLevel level, long long nanoseconds, long long passes, bool identical)
+{
+    printf("%8s %10d %8s %12.0f %10.2f %9s\n", kernel, items, GetSimdLevelName(level), (double)nanoseconds / passes,
+        (double)nanoseconds / passes / items, identical ? "yes" : "NO");
+}
+
+// Times OverlapBatch::Test on random pairs between asteroid sized circles and points spread over the screen,
+// about as dense as what the grid hands over, and checks that every level finds the same hits as the scalar loop
+static bool RunOverlapKernel(int pairCount, double minSeconds)
+{
+    static const int circleCount = 1000;
+    static const int pointCount = 1024;
+
+    Random random(54321);
+    std::vector<Scalar> circleX(circleCount), circleY(circleCount), circleRadius(circleCount);
+    std::vector<Scalar> pointX(pointCount), pointY(pointCount);
+    for (int i = 0; i < circleCount; i++)
+    {
+        circleX[i] = random.NextInt(RESOLUTION_X);
+        circleY[i] = random.NextInt(RESOLUTION_Y);
+        circleRadius[i] = (1 << random.NextInt(3)) * ASTEROID_SIZE_MULTIPLIER;
+    }
+    for (int i = 0; i < pointCount; i++)
+    {
+        pointX[i] = ScalarFromDouble(random.NextInt(RESOLUTION_X) + random.NextInt(1000) / 1000.0);
+        pointY[i] = ScalarFromDouble(random.NextInt(RESOLUTION_Y) + random.NextInt(1000) / 1000.0);
+    }
+    CircleSet circles = { circleX.data(), circleY.data(), circleRadius.data(), NULL, NULL };
+    CircleSet points = { pointX.data(), pointY.data(), NULL, NULL, NULL };
+
+    // Pairs close enough to overlap now and then, like candidates sharing a grid cell
+    OverlapBatch batch;
+    for (int p = 0; p < pairCount; p++)
+    {
+        int i = random.NextInt(circleCount);
+        int j = random.NextInt(pointCount);
+        pointX[j] = circleX[i] + random.NextInt(120) - 60;
+        pointY[j] = circleY[i] + random.NextInt(120) - 60;
+        batch.Add(i, j);
+    }
+
+    batch.Test(circles, points, SCALAR(1.2), SIMD_SCALAR);
+    std::vector<uint64_t> expected(batch.GetHits(), batch.GetHits() + (pairCount + 63) / 64);
+
+    // Packing is the same at every level: it's only loads and stores
+    long long packNanoseconds = 0;
+    long long packPasses = 0;
+    while (packPasses == 0 || packNanoseconds < minSeconds * 1e9)
+    {
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        for (int t = 0; t < TICKS_PER_ROUND; t++)
+        {
+            batch.Pack(circles, points);
+        }
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        packNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+        packPasses += TICKS_PER_ROUND;
+    }
+    PrintKernel("pack", pairCount, SIMD_SCALAR, packNanoseconds, packPasses, true);
+
+    bool allIdentical = true;
+    for (int level = SIMD_SCALAR; level <= GetSimdLevel(); level++)
+    {
+        long long nanoseconds = 0;
+        long long passes = 0;
+        while (passes == 0 || nanoseconds < minSeconds * 1e9)
+        {
+            std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+            for (int t = 0; t < TICKS_PER_ROUND; t++)
+            {
+                batch.TestPacked(SCALAR(1.2), (SimdLevel)level);
+            }
+            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+            nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+            passes += TICKS_PER_ROUND;
+        }
+
+        bool identical = memcmp(batch.GetHits(), expected.data(), expected.size() * sizeof(uint64_t)) == 0;
+        PrintKernel("overlap", pairCount, (SimdLevel)level, nanoseconds, passes, identical);
+        allIdentical = allIdentical && identical;
+    }
+
+    // The same pairs swept over a tick, the points coming from up to 40 pixels away: the packed test in front of the sweep
+    // must not change which pairs hit, nor when
+    std::vector<Scalar> previousX(pointCount), previousY(pointCount);
+    for (int i = 0; i < pointCount; i++)
+    {
+        previousX[i] = pointX[i] + random.NextInt(80) - 40;
+        previousY[i] = pointY[i] + random.NextInt(80) - 40;
+    }
+    CircleSet movingPoints = { pointX.data(), pointY.data(), NULL, previousX.data(), previousY.data() };
+    batch.Sweep(circles, movingPoints, 1, SIMD_SCALAR);
+    expected.assign(batch.GetHits(), batch.GetHits() + (pairCount + 63) / 64);
+    std::vector<Scalar> expectedTimes(pairCount);
+    for (int p = 0; p < pairCount; p++)
+    {
+        expectedTimes[p] = batch.GetTime(p);
+    }
+
+    for (int level = SIMD_SCALAR; level <= GetSimdLevel(); level++)
+    {
+        long long nanoseconds = 0;
+        long long passes = 0;
+        while (passes == 0 || nanoseconds < minSeconds * 1e9)
+        {
+            std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+            for (int t = 0; t < TICKS_PER_ROUND; t++)
+            {
+                batch.Sweep(circles, movingPoints, 1, (SimdLevel)level);
+            }
+            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+            nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+            passes += TICKS_PER_ROUND;
+        }
+
+        bool identical = memcmp(batch.GetHits(), expected.data(), expected.size() * sizeof(uint64_t)) == 0;
+        for (int p = 0; p < pairCount && identical; p++)
+        {
+            identical = batch.GetTime(p) == expectedTimes[p];
+        }
+        PrintKernel("sweep", pairCount, (SimdLevel)level, nanoseconds, passes, identical);
+        allIdentical = allIdentical && identical;
+    }
+    return allIdentical;
+}
+
+// Publishes a few rounds of events past the log's capacity, with one reader keeping up and one reading only at the end.
+// The one keeping up must get every event in order, the late one the newest GAME_EVENT_CAPACITY of them,
+// with everything before counted as dropped
+static bool CheckEventReaders()
+{
+    static const int eventCount = GAME_EVENT_CAPACITY * 3 + 5;
+
+    GameEventLog log;
+    GameEventReader live;
+    GameEventReader late;
+    live.Attach(&log);
+    late.Attach(&log);
+
+    bool correct = true;
+    Point2D position = { 0, 0 };
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < eventCount; i++)
+    {
+        log.Publish(GAME_EVENT_PROJECTILE_FIRED, i, position, i);
+        const GameEvent* event = live.Next();
+        correct = correct && event != NULL && event->data == i && live.Next() == NULL;
+    }
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    correct = correct && live.GetDropped() == 0;
+
+    int expected = eventCount - GAME_EVENT_CAPACITY;
+    for (const GameEvent* event = late.Next(); event != NULL; event = late.Next())
+    {
+        correct = correct && event->data == expected;
+        expected++;
+    }
+    correct = correct && expected == eventCount && late.GetDropped() == eventCount - GAME_EVENT_CAPACITY;
+
+    // A reader attached now only gets what comes next
+    GameEventReader fresh;
+    fresh.Attach(&log);
+    correct = correct && fresh.Next() == NULL;
+
+    PrintKernel("events", eventCount, SIMD_SCALAR, std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count(), 1, correct);
+    return correct;
+}
+
+// Converts frames of pure red, green, blue, white and black to YUV, and checks every plane against full range BT.601.
+// The saturated colors push U or V to the very end of the byte
+static bool CheckYuvConversion()
+{
+    struct Expected
+    {
+        uint32_t color;
+        unsigned char y, u, v;
+    };
+    static const Expected colors[] = {
+        { 0xFF0000, 76, 85, 255 },
+        { 0x00FF00, 150, 44, 21 },
+        { 0x0000FF, 29, 255, 107 },
+        { 0xFFFFFF, 255, 128, 128 },
+        { 0x000000, 0, 128, 128 },
+    };
+    static const int pixelCount = RESOLUTION_X * RESOLUTION_Y;
+    static const int chromaCount = pixelCount / 4;
+
+    std::vector<uint32_t> pixels(pixelCount);
+    std::vector<unsigned char> bytes(pixelCount + chromaCount * 2);
+    bool correct = true;
+    long long nanoseconds = 0;
+    for (int c = 0; c < 5; c++)
+    {
+        std::fill(pixels.begin(), pixels.end(), colors[c].color);
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        VideoExporter::ConvertToYuv(pixels.data(), bytes.data());
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+
+        for (int i = 0; i < pixelCount && correct; i++)
+        {
+            correct = bytes[i] == colors[c].y;
+        }
+        for (int i = 0; i < chromaCount && correct; i++)
+        {
+            correct = bytes[pixelCount + i] == colors[c].u && bytes[pixelCount + chromaCount + i] == colors[c].v;
+        }
+    }
+
+    PrintKernel("yuv", pixelCount, SIMD_SCALAR, nanoseconds, 5, correct);
+    return correct;
+}
+
+// Times the SIMD kernels at every level this CPU has, and checks that they all end up with the same bits as the scalar loop.
+// The odd counts leave a remainder for the scalar loop after the vector loops
+static int RunKernels(double minSeconds)
+{
+    static const int counts[] = { 1000, 100000, 100003 };
+
+    int result = 0;
+    printf("%8s %10s %8s %12s %10s %9s\n", "kernel", "items", "simd", "ns/pass", "ns/item", "identical");
+    for (int c = 0; c < 3; c++)
+    {
+        Random random(12345);
+        MotionData start(counts[c], random);
+
+        MotionData expected = start;
+        for (int t = 0; t < TICKS_PER_ROUND; t++)
+        {
+            IntegrateMotion(expected.GetArrays(), counts[c], SCALAR(1.0 / 60), true, SIMD_SCALAR);
+        }
+
+        for (int level = SIMD_SCALAR; level <= GetSimdLevel(); level++)
+        {
+            long long nanoseconds = 0;
+            long long passes = 0;
+            bool identical = true;
+            MotionData data = start;
+            while (passes == 0 || nanoseconds < minSeconds * 1e9)
+            {
+                data = start;
+                std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+                for (int t = 0; t < TICKS_PER_ROUND; t++)
+                {
+                    IntegrateMotion(data.GetArrays(), counts[c], SCALAR(1.0 / 60), true, (SimdLevel)level);
+                }
+                std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+                nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+                passes += TICKS_PER_ROUND;
+                identical = identical && data == expected;
+            }
+
+            PrintKernel("motion", counts[c], (SimdLevel)level, nanoseconds, passes, identical);
+            if (!identical)
+            {
+                result = 1;
+            }
+        }
+    }
+
+    for (int c = 0; c < 3; c++)
+    {
+        if (!RunOverlapKernel(counts[c], minSeconds))
+        {
+            result = 1;
+        }
+    }
+
+    if (!CheckEventReaders())
+    {
+        result = 1;
+    }
+    if (!CheckYuvConversion())
+    {
+        result = 1;
+    }
+    return result;
+}
+
+static void PrintTable(const std::vector<Scenario>& scenarios)
+{
+    printf("%10s %11s %12s %10s %10s %8s %12s %9s", "asteroids", "projectiles", "ns/tick", "ns/ast.", "allocs", "scaling", "draw ns", "batches");
+    for (int p = 0; p < PHASE_COUNT; p++)
+    {
+        printf(" %s", EngineProfile::GetPhaseName(p));
+    }
+    printf("\n");
+
+    for (size_t i = 0; i < scenarios.size(); i++)
+    {
+        const Scenario& s = scenarios[i];
+        printf("%10d %11d %12.0f %10.1f %10.2f", s.asteroids, s.projectiles, s.nanosecondsPerTick,
+            s.nanosecondsPerTick / s.averageAsteroids, s.allocationsPerTick);
+        if (s.scalingExponent > 0)
+            printf(" %8.2f", s.scalingExponent);
+        else
+            printf(" %8s", "-");
+        printf(" %12.0f %9.1f", s.drawNanosecondsPerFrame, s.drawBatchesPerFrame);
+        for (int p = 0; p < PHASE_COUNT; p++)
+        {
+            printf(" %.0f", (double)s.profile.nanoseconds[p] / s.profile.ticks);
+        }
+        printf("\n");
+    }
+}
+
+static bool WriteJson(const std::vector<Scenario>& scenarios, const char* path)
+{
+    FILE* file = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+    if (file == NULL)
+    {
+        return false;
+    }
+
+    fprintf(file, "{\n  \"ticks_per_round\": %d,\n  \"scenarios\": [\n", TICKS_PER_ROUND);
+    for (size_t i = 0; i < scenarios.size(); i++)
+    {
+        const Scenario& s = scenarios[i];
+        fprintf(file, "    {\"asteroids\": %d, \"projectiles\": %d, \"ticks\": %lld, \"ns_per_tick\": %.1f, "
+            "\"ns_per_asteroid\": %.3f, \"allocations_per_tick\": %.3f, \"average_asteroids\": %.1f, ",
+            s.asteroids, s.projectiles, s.ticks, s.nanosecondsPerTick,
+            s.nanosecondsPerTick / s.averageAsteroids, s.allocationsPerTick, s.averageAsteroids);
+        if (s.scalingExponent > 0)
+            fprintf(file, "\"scaling_exponent\": %.3f, ", s.scalingExponent);
+        else
+            fprintf(file, "\"scaling_exponent\": null, ");
+
+        fprintf(file, "\"draw_ns_per_frame\": %.1f, \"draw_commands_per_frame\": %.1f, \"draw_batches_per_frame\": %.2f, ",
+            s.drawNanosecondsPerFrame, s.drawCommandsPerFrame, s.drawBatchesPerFrame);
+        fprintf(file, "\"phases_ns_per_tick\": {");
+        for (int p = 0; p < PHASE_COUNT; p++)
+        {
+            fprintf(file, "%s\"%s\": %.1f", p > 0 ? ", " : "", EngineProfile::GetPhaseName(p),
+                (double)s.profile.nanoseconds[p] / s.profile.ticks);
+        }
+        fprintf(file, "}}%s\n", i + 1 < scenarios.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+
+    if (file != stdout)
+    {
+        return fclose(file) == 0;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    double minSeconds = 0.5;
+    int maxAsteroids = 100000;
+    const char* jsonPath = NULL;
+    bool kernels = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--time") == 0 && i + 1 < argc)
+            minSeconds = atof(argv[++i]);
+        else if (strcmp(argv[i], "--max-asteroids") == 0 && i + 1 < argc)
+            maxAsteroids = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+            jsonPath = argv[++i];
+        else if (strcmp(argv[i], "--kernels") == 0)
+            kernels = true;
+        else
+        {
+            fprintf(stderr, "Usage: %s [--time seconds] [--max-asteroids N] [--json file|-]\n", argv[0]);
+            fprintf(stderr, "       %s --kernels [--time seconds]\n", argv[0]);
+            fprintf(stderr, "Each scenario is measured for at least --time seconds (after one warm-up round)\n");
+            fprintf(stderr, "With --kernels, the motion, overlap and sweep kernels are timed at every SIMD level, and fails if any differs from the scalar loop (or the event readers lose track, or the YUV conversion is off)\n");
+            return 1;
+        }
+    }
+
+    if (kernels)
+    {
+        return RunKernels(minSeconds);
+    }
+
+    std::vector<Scenario> scenarios;
+    int projectileLoads = sizeof(PROJECTILE_LOADS) / sizeof(PROJECTILE_LOADS[0]);
+    int asteroidCounts = sizeof(ASTEROID_COUNTS) / sizeof(ASTEROID_COUNTS[0]);
+    for (int p = 0; p < projectileLoads; p++)
+    {
+        for (int a = 0; a < asteroidCounts; a++)
+        {
+            if (ASTEROID_COUNTS[a] > maxAsteroids)
+            {
+                continue;
+            }
+
+            Scenario scenario;
+            scenario.asteroids = ASTEROID_COUNTS[a];
+            scenario.projectiles = PROJECTILE_LOADS[p];
+            RunScenario(scenario, minSeconds, 1.0 / 60);
+
+            scenario.scalingExponent = 0;
+            if (a > 0 && !scenarios.empty() && scenarios.back().projectiles == scenario.projectiles)
+            {
+                const Scenario& previous = scenarios.back();
+                scenario.scalingExponent = log(scenario.nanosecondsPerTick / previous.nanosecondsPerTick)
+                    / log(scenario.averageAsteroids / previous.averageAsteroids);
+            }
+            scenarios.push_back(scenario);
+
+            if (jsonPath == NULL || strcmp(jsonPath, "-") != 0)
+            {
+                fprintf(stderr, "%d asteroids, %d projectiles: %.0f ns/tick\n", scenario.asteroids, scenario.projectiles, scenario.nanosecondsPerTick);
+            }
+        }
+    }
+
+    if (jsonPath != NULL)
+    {
+        if (!WriteJson(scenarios, jsonPath))
+        {
+            fprintf(stderr, "Can't write %s\n", jsonPath);
+            return 1;
+        }
+        if (strcmp(jsonPath, "-") == 0)
+        {
+            return 0;
+        }
+    }
+
+    PrintTable(scenarios);
+    return 0;
+}
@@ -0,0 +1,64 @@
+#include <chrono>
+#include <thread>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include "Clock.h"
+
+#ifdef _WIN32
+// Only in recent SDKs. Older versions of Windows refuse it, and we fall back to a normal sleep
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#endif
+
+SystemClock::SystemClock() : timer(NULL)
+{
+#ifdef _WIN32
+    timer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+#endif
+}
+
+SystemClock::~SystemClock()
+{
+#ifdef _WIN32
+    if (timer != NULL)
+    {
+        CloseHandle(timer);
+    }
+#endif
+}
+
+long long SystemClock::Now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void SystemClock::Sleep(long long duration)
+{
+    if (duration <= 0)
+    {
+        return;
+    }
+
+#ifdef _WIN32
+    if (timer != NULL)
+    {
+        // Negative due times are relative, in 100 ns units
+        LARGE_INTEGER dueTime;
+        dueTime.QuadPart = -(duration / 100);
+        if (SetWaitableTimer(timer, &dueTime, 0, NULL, NULL, FALSE))
+        {
+            WaitForSingleObject(timer, INFINITE);
+            return;
+        }
+    }
+#endif
+
+    std::this_thread::sleep_for(std::chrono::nanoseconds(duration));
+}
+
+void SystemClock::Spin()
+{
+    std::this_thread::yield();
+}
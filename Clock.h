@@ -0,0 +1,69 @@
+#pragma once
+
+// Where the frame pacer gets its time from and how it waits.
+// All times are in nanoseconds, from an arbitrary starting point
+class Clock
+{
+public:
+	virtual ~Clock()
+	{
+	}
+
+	virtual long long Now() = 0;
+	// Sleeps for about this long. It can oversleep by the scheduler's granularity, never undersleep much
+	virtual void Sleep(long long duration) = 0;
+	// Called while spinning for the last microseconds before a deadline
+	virtual void Spin() = 0;
+};
+
+// The real clock. On Windows sleeps use a high-resolution waitable timer when the system has one,
+// which wakes up within about half a millisecond instead of the default 15.6 ms timer tick
+class SystemClock : public Clock
+{
+public:
+	SystemClock();
+	~SystemClock();
+
+	long long Now() override;
+	void Sleep(long long duration) override;
+	void Spin() override;
+
+private:
+	// Windows timer handle, NULL elsewhere or when it couldn't be created
+	void* timer;
+};
+
+// A clock that only moves when it's told to, so pacing can be checked without waiting.
+// Every sleep oversleeps by a fixed amount, like a real scheduler would
+class ManualClock : public Clock
+{
+public:
+	ManualClock(long long oversleep, long long yieldStep) : time(0), oversleep(oversleep), yieldStep(yieldStep)
+	{
+	}
+
+	long long Now() override
+	{
+		return time;
+	}
+
+	void Sleep(long long duration) override
+	{
+		time += duration + oversleep;
+	}
+
+	void Spin() override
+	{
+		time += yieldStep;
+	}
+
+	void Advance(long long duration)
+	{
+		time += duration;
+	}
+
+private:
+	long long time;
+	long long oversleep;
+	long long yieldStep;
+};
@@ -0,0 +1,117 @@
+#include "CommandList.h"
+
+CommandList::CommandList()
+{
+	bucketStarts.resize(PRIMITIVE_COUNT * BRUSH_COUNT + 1);
+}
+
+CommandList::~CommandList()
+{
+}
+
+void CommandList::Clear()
+{
+	commands.clear();
+	points.clear();
+	order.clear();
+}
+
+int CommandList::AddCommand(RenderPrimitive primitive, RenderBrush brush, int pointCount, float size)
+{
+	RenderCommand command;
+	command.primitive = (unsigned char)primitive;
+	command.brush = (unsigned char)brush;
+	command.pointCount = (unsigned short)pointCount;
+	command.firstPoint = (unsigned int)points.size();
+	command.size = size;
+	command.text = NULL;
+	commands.push_back(command);
+	order.push_back((int)commands.size() - 1);
+	return (int)commands.size() - 1;
+}
+
+void CommandList::AddPolyline(RenderBrush brush, const RenderPoint* newPoints, int count, float width)
+{
+	AddCommand(PRIMITIVE_POLYLINE, brush, count, width);
+	points.insert(points.end(), newPoints, newPoints + count);
+}
+
+void CommandList::AddTriangle(RenderBrush brush, RenderPoint a, RenderPoint b, RenderPoint c)
+{
+	AddCommand(PRIMITIVE_TRIANGLE, brush, 3, 0);
+	points.push_back(a);
+	points.push_back(b);
+	points.push_back(c);
+}
+
+void CommandList::AddCircle(RenderBrush brush, RenderPoint center, float radius)
+{
+	AddCommand(PRIMITIVE_CIRCLE, brush, 1, radius);
+	points.push_back(center);
+}
+
+void CommandList::AddText(RenderBrush brush, const char* text, RenderPoint topLeft, RenderPoint bottomRight)
+{
+	int index = AddCommand(PRIMITIVE_TEXT, brush, 2, 0);
+	commands[index].text = text;
+	points.push_back(topLeft);
+	points.push_back(bottomRight);
+}
+
+void CommandList::Sort()
+{
+	// There are only a few groups, so a counting sort does it in two passes and keeps the order within each group
+	int bucketCount = PRIMITIVE_COUNT * BRUSH_COUNT;
+	for (int b = 0; b <= bucketCount; b++)
+	{
+		bucketStarts[b] = 0;
+	}
+	for (size_t i = 0; i < commands.size(); i++)
+	{
+		bucketStarts[commands[i].primitive * BRUSH_COUNT + commands[i].brush + 1]++;
+	}
+	for (int b = 0; b < bucketCount; b++)
+	{
+		bucketStarts[b + 1] += bucketStarts[b];
+	}
+	for (size_t i = 0; i < commands.size(); i++)
+	{
+		order[bucketStarts[commands[i].primitive * BRUSH_COUNT + commands[i].brush]++] = (int)i;
+	}
+}
+
+int CommandList::GetCount()
+{
+	return (int)commands.size();
+}
+
+const RenderCommand& CommandList::GetCommand(int index)
+{
+	return commands[order[index]];
+}
+
+const RenderPoint* CommandList::GetPoints(const RenderCommand& command)
+{
+	return &points[command.firstPoint];
+}
+
+int CommandList::GetBatchEnd(int index)
+{
+	const RenderCommand& first = GetCommand(index);
+	int end = index + 1;
+	while (end < GetCount() && GetCommand(end).primitive == first.primitive && GetCommand(end).brush == first.brush)
+	{
+		end++;
+	}
+	return end;
+}
+
+int CommandList::GetBatchCount()
+{
+	int batches = 0;
+	for (int i = 0; i < GetCount(); i = GetBatchEnd(i))
+	{
+		batches++;
+	}
+	return batches;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+
+// The colors things are drawn with. Backends create one brush per color, once
+enum RenderBrush
+{
+	BRUSH_WHITE,
+	BRUSH_GREEN,
+	BRUSH_ORANGE,
+	BRUSH_BLUE,
+	BRUSH_YELLOW,
+	BRUSH_RED,
+	BRUSH_COUNT
+};
+
+// Kinds of shapes, in the order they are drawn: text goes last, on top of everything
+enum RenderPrimitive
+{
+	PRIMITIVE_POLYLINE,
+	PRIMITIVE_TRIANGLE,
+	PRIMITIVE_CIRCLE,
+	PRIMITIVE_TEXT,
+	PRIMITIVE_COUNT
+};
+
+// Same layout as a Direct2D point, so backends can hand the points over without copying
+struct RenderPoint
+{
+	float x;
+	float y;
+};
+
+struct RenderCommand
+{
+	unsigned char primitive;
+	unsigned char brush;
+	unsigned short pointCount;
+	// Where the command's points start in the list's point array
+	unsigned int firstPoint;
+	// Line width of a polyline, radius of a circle
+	float size;
+	// Only for text. Must outlive the list, string literals are best
+	const char* text;
+};
+
+// Everything to draw in a frame, as plain data that any backend can draw (or not draw).
+// After Sort, commands are grouped by primitive and brush, so a backend can draw each group with one brush and,
+// where its API allows, one call. Points of all the commands live in one array.
+// The list keeps its memory between frames, so once it has grown to the size of a frame it doesn't allocate
+class CommandList
+{
+public:
+	CommandList();
+	~CommandList();
+
+	void Clear();
+
+	// Closed outline through the points
+	void AddPolyline(RenderBrush brush, const RenderPoint* points, int count, float width);
+	void AddTriangle(RenderBrush brush, RenderPoint a, RenderPoint b, RenderPoint c);
+	void AddCircle(RenderBrush brush, RenderPoint center, float radius);
+	// Text centered in the rectangle from topLeft to bottomRight
+	void AddText(RenderBrush brush, const char* text, RenderPoint topLeft, RenderPoint bottomRight);
+
+	// Groups the commands by primitive then brush, keeping their order within a group
+	void Sort();
+
+	int GetCount();
+	// The commands in sorted order (in the order they were added if Sort wasn't called)
+	const RenderCommand& GetCommand(int index);
+	const RenderPoint* GetPoints(const RenderCommand& command);
+	// End of the group of commands starting at index: same primitive and brush
+	int GetBatchEnd(int index);
+	// How many groups there are, that is how many times a backend has to change brush or primitive
+	int GetBatchCount();
+
+private:
+	int AddCommand(RenderPrimitive primitive, RenderBrush brush, int pointCount, float size);
+
+	std::vector<RenderCommand> commands;
+	std::vector<RenderPoint> points;
+	// Sorted order of the commands, and scratch space for sorting
+	std::vector<int> order;
+	std::vector<int> bucketStarts;
+};
@@ -1,421 +1,791 @@
-#include "framework.h"
-#include "Ship.h"
+#include <math.h>
+#include <algorithm>
 #include "Engine.h"
 
-#pragma comment(lib, "d2d1")
-#pragma comment(lib, "dwrite")
+EngineConfig::EngineConfig()
+{
+    maxProjectiles = 20;
+    // Long enough that, like in the original game, projectiles only disappear when they leave the screen
+    projectileTimeToLive = 3;
+    projectileRange = 1200;
+    seed = 1;
+    tickTime = 1.0 / 60;
+}
+
+EngineProfile::EngineProfile()
+{
+    Reset();
+}
+
+void EngineProfile::Reset()
+{
+    ticks = 0;
+    for (int i = 0; i < PHASE_COUNT; i++)
+    {
+        nanoseconds[i] = 0;
+    }
+}
+
+const char* EngineProfile::GetPhaseName(int phase)
+{
+    static const char* names[PHASE_COUNT] = { "timers", "input", "ship", "projectiles", "asteroids", "particles", "broadphase", "projectile_collisions", "ship_collisions" };
+    return phase >= 0 && phase < PHASE_COUNT ? names[phase] : "unknown";
+}
 
-Engine::Engine() : m_pDirect2dFactory(NULL), m_pRenderTarget(NULL), m_pWhiteBrush(NULL)
+Engine::Engine() :
+    recording(NULL),
+    profile(NULL),
+    tracePhases(false),
+    projectiles(config.maxProjectiles, config.projectileTimeToLive, config.projectileRange),
+    grid(GRID_CELL_SIZE, RESOLUTION_X + 2 * SCREEN_MARGIN, RESOLUTION_Y + 2 * SCREEN_MARGIN, -SCREEN_MARGIN, -SCREEN_MARGIN)
 {
     // Initilize the main ship
     ship = new Ship();
+    respawnTicks = GetDelayTicks(SHIP_RESPAWN_TIME, config.tickTime);
 
-    // Number of projectiles on the screen is initially 0
-    noProjectiles = 0;
+    NewGame(config.seed);
+}
 
-    // Initializes 6 big asteroids
-    noAsteroids = 6;
-    for (int i = 0; i < noAsteroids; i++)
+Engine::Engine(const EngineConfig& config) :
+    config(config),
+    recording(NULL),
+    profile(NULL),
+    tracePhases(false),
+    projectiles(config.maxProjectiles, config.projectileTimeToLive, config.projectileRange),
+    grid(GRID_CELL_SIZE, RESOLUTION_X + 2 * SCREEN_MARGIN, RESOLUTION_Y + 2 * SCREEN_MARGIN, -SCREEN_MARGIN, -SCREEN_MARGIN)
+{
+    // Initilize the main ship
+    ship = new Ship();
+    respawnTicks = GetDelayTicks(SHIP_RESPAWN_TIME, config.tickTime);
+
+    NewGame(config.seed);
+}
+
+void Engine::NewGame(uint64_t newSeed)
+{
+    // Everything random in the game comes from this generator, so the same seed always plays the same game
+    if (recording != NULL)
     {
-        asteroids[i] = new Asteroid();
+        recording->RecordNewGame(tick, newSeed);
     }
 
-    // Initializes 3 ships representing lives left. 
-    //These are purely for drawing the lives left on the screen, we don't actually control them or check for collisions
-    lives = 3;
-    for (int i = 0; i < lives; i++)
+    seed = newSeed;
+    random.Seed(seed);
+    tick = 0;
+    timers.Clear(tick);
+
+    // The ship starts in the center
+    ship->Reset();
+
+    // There are no projectiles on the screen initially, and nothing exploded yet
+    projectiles.Clear();
+    particles.Clear();
+
+    // Initializes 6 big asteroids
+    asteroids.Clear();
+    for (int i = 0; i < 6; i++)
     {
-        Ship* lifeShip = new Ship(i);
-        lifeShips[i] = lifeShip;
+        asteroids.Spawn(random);
     }
 
+    // 3 lives left
+    lives = 3;
+
     // Reset keys
     leftPressed = false;
     rightPressed = false;
     accelerationPressed = false;
     firePressed = 0;
+    leftHeld = 0;
+    rightHeld = 0;
+    accelerationHeld = 0;
 
     gameOver = false;
+    gameWon = false;
+
+    PublishEvent(GAME_EVENT_NEW_GAME, ship->GetPosition(), 0);
 }
 
 Engine::~Engine()
 {
-    SafeRelease(&m_pDirect2dFactory);
-    SafeRelease(&m_pRenderTarget);
-}
-
-HRESULT Engine::InitializeD2D(HWND m_hwnd)
-{
-    // Initializes Direct2D, to draw with
-    D2D1_SIZE_U size = D2D1::SizeU(RESOLUTION_X, RESOLUTION_Y);
-    D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED, &m_pDirect2dFactory);
-    m_pDirect2dFactory->CreateHwndRenderTarget(
-        D2D1::RenderTargetProperties(),
-        D2D1::HwndRenderTargetProperties(m_hwnd, size, D2D1_PRESENT_OPTIONS_IMMEDIATELY),
-        &m_pRenderTarget
-    );
-
-    // Initialize text writing factory and format
-    DWriteCreateFactory(
-        DWRITE_FACTORY_TYPE_SHARED,
-        __uuidof(m_pDWriteFactory),
-        reinterpret_cast<IUnknown**>(&m_pDWriteFactory)
-    );
-
-    m_pDWriteFactory->CreateTextFormat(
-        L"Verdana",
-        NULL,
-        DWRITE_FONT_WEIGHT_NORMAL,
-        DWRITE_FONT_STYLE_NORMAL,
-        DWRITE_FONT_STRETCH_NORMAL,
-        60,
-        L"", //locale
-        &m_pTextFormat
-    );
-
-    m_pTextFormat->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_CENTER);
-
-    m_pTextFormat->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_CENTER);
-
-    m_pRenderTarget->CreateSolidColorBrush(
-        D2D1::ColorF(D2D1::ColorF::White),
-        &m_pWhiteBrush
-    );
-
-    // Initialize the Direct2D for the ship
-    ship->InitializeD2D(m_pRenderTarget);
-
-    // Initialize the Direct2D for the asteroids
-    for (int i = 0; i < noAsteroids; i++)
-    {
-        asteroids[i]->InitializeD2D(m_pRenderTarget);
-    }
+    delete ship;
+}
 
-    // Initialize the Direct2D for the "lives" ships
-    for (int i = 0; i < lives; i++)
+// The part of the next tick a key is held for. A key pressed or released partway through a tick only counts for its part of it
+static void ChangeKey(bool& pressed, double& heldFraction, bool down, double offset)
+{
+    if (pressed == down)
     {
-        lifeShips[i]->InitializeD2D(m_pRenderTarget);
+        // Windows repeats the key down message while a key is held
+        return;
     }
+    pressed = down;
+    heldFraction += down ? 1 - offset : offset - 1;
+}
+
+void Engine::KeyUp(unsigned int key)
+{
+    KeyUp(key, 0);
+}
 
-    return S_OK;
+void Engine::KeyDown(unsigned int key)
+{
+    KeyDown(key, 0);
 }
 
-void Engine::KeyUp(WPARAM wParam)
+void Engine::KeyUp(unsigned int key, double offset)
 {
+    // Offsets are rounded the same way they are recorded, so a replay gets exactly the same values
+    int offsetSteps = QuantizeOffset(offset);
+    offset = (double)offsetSteps / INPUT_OFFSET_STEPS;
+
+    if (recording != NULL)
+    {
+        recording->RecordKey(tick, key, false, offsetSteps);
+    }
+
     // If keyup, we un-set the keys flags
     // We don't do any logic here, because we want to control the logic in the Logic method
     if (!gameOver || gameWon)
     { // We can control the ship only if the game is not lost
-        if (wParam == VK_LEFT)
-            leftPressed = false;
-        if (wParam == VK_RIGHT)
-            rightPressed = false;
-        if (wParam == VK_UP)
-            accelerationPressed = false;
-        if (wParam == VK_SPACE)
+        if (key == VK_LEFT)
+            ChangeKey(leftPressed, leftHeld, false, offset);
+        if (key == VK_RIGHT)
+            ChangeKey(rightPressed, rightHeld, false, offset);
+        if (key == VK_UP)
+            ChangeKey(accelerationPressed, accelerationHeld, false, offset);
+        if (key == VK_SPACE)
+        {
             if (firePressed == 2)
                 firePressed = 0;
+            else if (firePressed == 1)
+                firePressed = 3; // Tapped between two ticks: it still fires once
+        }
     }
 }
 
-void Engine::KeyDown(WPARAM wParam)
+void Engine::KeyDown(unsigned int key, double offset)
 {
+    int offsetSteps = QuantizeOffset(offset);
+    offset = (double)offsetSteps / INPUT_OFFSET_STEPS;
+
+    if (recording != NULL)
+    {
+        recording->RecordKey(tick, key, true, offsetSteps);
+    }
+
     // If keyup, we set the keys flags
     // We don't do any logic here, because we want to control the logic in the Logic method
     if (!gameOver || gameWon)
     { // We can control the ship only if the game is not lost
-        if (wParam == VK_LEFT)
-            leftPressed = true;
-        if (wParam == VK_RIGHT)
-            rightPressed = true;
-        if (wParam == VK_UP)
-            accelerationPressed = true;
-        if (wParam == VK_SPACE)
+        if (key == VK_LEFT)
+            ChangeKey(leftPressed, leftHeld, true, offset);
+        if (key == VK_RIGHT)
+            ChangeKey(rightPressed, rightHeld, true, offset);
+        if (key == VK_UP)
+            ChangeKey(accelerationPressed, accelerationHeld, true, offset);
+        if (key == VK_SPACE)
             if (firePressed == 0)
                 firePressed = 1;
     }
 }
 
+long long Engine::GetDelayTicks(double seconds, double tickTime)
+{
+    // The first tick more than that many seconds later. A tick length that makes no sense gets the shortest delay
+    if (!(tickTime > 0) || seconds / tickTime >= 1e9)
+        return 1;
+    return (long long)(seconds / tickTime) + 1;
+}
+
+int Engine::QuantizeOffset(double offset)
+{
+    int steps = (int)(offset * INPUT_OFFSET_STEPS);
+    if (steps < 0)
+        return 0;
+    if (steps >= INPUT_OFFSET_STEPS)
+        return INPUT_OFFSET_STEPS - 1;
+    return steps;
+}
+
+// Center and half size of the square around a path from start to end
+static Point2D GetPathBox(Point2D start, Point2D end, double& radius)
+{
+    Point2D center;
+    center.x = (start.x + end.x) / 2;
+    center.y = (start.y + end.y) / 2;
+    radius = std::max(fabs(end.x - start.x), fabs(end.y - start.y)) / 2;
+    return center;
+}
+
 void Engine::Logic(double elapsedTime)
 {
-    // This is the logic part of the engine. It receives the elapsed time from the app class, in seconds.
-    // It uses this value for a smooth and consistent movement, regardless of the CPU or graphics speed
+    // This is the logic part of the engine. It receives the length of one simulation tick, in seconds.
+    // The app runs it at a fixed rate (see FixedTimestep), so the results don't depend on the CPU or graphics speed
+
+    TRACE_SCOPE("Logic");
+    tracePhases = Trace::IsEnabled();
+    if (profile != NULL || tracePhases)
+    {
+        if (profile != NULL)
+        {
+            profile->ticks++;
+        }
+        phaseStart = Trace::Now();
+    }
+
+    tick++;
+    ship->StorePreviousState();
 
+    // The physics works in its own numbers (see Scalar.h), the tick length is converted once
+    Scalar dt = ScalarFromDouble(elapsedTime);
 
-    if (leftPressed)
+    // Whatever was waiting for this tick happens now. Only the timers due go off, however many are waiting
+    firedTimers.clear();
+    timers.Advance(firedTimers);
+    for (size_t t = 0; t < firedTimers.size(); t++)
+    {
+        HandleTimer(firedTimers[t]);
+    }
+    EndPhase(PHASE_TIMERS);
+
+    // Rotation and thrust only apply for the part of the tick their key was held
+    if (leftHeld > 0)
     {
         if (!ship->IsExploded())
         {
             // If we pressed left and the ship is not exploded, we rotate it
-            ship->ApplyLeftRotation(elapsedTime);
+            ship->ApplyLeftRotation(dt * ScalarFromDouble(leftHeld));
         }
     }
-    if (rightPressed)
+    if (rightHeld > 0)
     {
         if (!ship->IsExploded())
         {
             // If we pressed right and the ship is not exploded, we rotate it
-            ship->ApplyRightRotation(elapsedTime);
+            ship->ApplyRightRotation(dt * ScalarFromDouble(rightHeld));
         }
     }
-    if (accelerationPressed)
+    if (accelerationHeld > 0)
     {
         if (!ship->IsExploded())
         {
             // If we pressed up and the ship is not exploded, we accelerate it
-            ship->ApplyAcceleration(elapsedTime);
+            ship->ApplyAcceleration(dt * ScalarFromDouble(accelerationHeld));
         }
     }
-    if (firePressed == 1)
+    // The keys still down are held for all of the next tick
+    leftHeld = leftPressed ? 1 : 0;
+    rightHeld = rightPressed ? 1 : 0;
+    accelerationHeld = accelerationPressed ? 1 : 0;
+
+    if (firePressed == 1 || firePressed == 3)
     {
         if (!ship->IsExploded())
         {
-            if (noProjectiles < 20)
+            // If we pressed fire (SPACE key), we create a projectile, starting from the position of the ship and going in the direction the ship is faced.
+            // Nothing happens if there are already too many projectiles on the screen
+            if (projectiles.Spawn(ship->GetPosition(), ship->GetRotation()))
             {
-                // If we pressed fire (SPACE key), we create a projectile, starting from the position of the ship and going in the direction the ship is faced
-                Projectile* projectile = new Projectile(ship->GetPosition(), ship->GetRotation());
-                projectile->InitializeD2D(m_pRenderTarget);
-                projectiles[noProjectiles] = projectile;
-                noProjectiles++;
+                PublishEvent(GAME_EVENT_PROJECTILE_FIRED, ship->GetPosition(), 0);
             }
         }
-        firePressed = 2;
+        // Wait for the key to be released before firing again, unless it already was
+        firePressed = firePressed == 3 ? 0 : 2;
     }
+    EndPhase(PHASE_INPUT);
 
     // Ship logic : move the ship
-    ship->Advance(elapsedTime);
-    if (ship->IsExploded() && ship->GetExplosionTime() > 0.5)
+    ship->Advance(dt);
+    EndPhase(PHASE_SHIP);
+
+    // Projectile logic : move the projectiles. The ones that left the screen or expired are only eliminated after the collisions,
+    // so they can still hit something on their way out
+    projectiles.Advance(dt);
+    EndPhase(PHASE_PROJECTILES);
+
+    // Asteroid logic : move the asteroids
+    asteroids.Advance(dt);
+    EndPhase(PHASE_ASTEROIDS);
+
+    // Explosion debris flies away and disappears after a while
+    particles.Advance(dt);
+    EndPhase(PHASE_PARTICLES);
+
+    // Projectile to asteroid collisions
+    // The asteroids go into a grid first, so each projectile is only tested against the asteroids around it
+    BuildAsteroidGrid();
+    EndPhase(PHASE_BROADPHASE);
+
+    // The grid gives us every asteroid near the path of each projectile this tick, and all those pairs are swept at once
+    // against the asteroids' bounding circles, so even a long tick can't carry a projectile through a small asteroid.
+    // Only the few pairs that get that close are checked against the asteroid's real outline
+    overlaps.Clear();
+    overlapProjectiles.clear();
+    for (int j = 0; j < projectiles.GetCount(); j++)
     {
-        // If the ship is exploded and 0.5 seconds has passed, we reset it and decrease the lives.
-        ship->Reset();
-        lives--;
-        if (lives < 0)
+        if (!projectiles.IsAlive(j))
         {
-            // Game Over
-            gameOver = true;
-            gameWon = false;
+            continue;
+        }
+
+        double pathRadius;
+        Point2D pathCenter = GetPathBox(projectiles.GetPreviousPosition(j), projectiles.GetPosition(j), pathRadius);
+        grid.Query(pathCenter, pathRadius, candidates);
+        for (size_t c = 0; c < candidates.size(); c++)
+        {
+            overlaps.Add(candidates[c], projectiles.GetSlot(j));
+            overlapProjectiles.push_back(j);
         }
     }
 
-    // Projectile logic
-    for (int i = 0; i < noProjectiles; i++)
+    // We collect every hit, then sort them by when they happened,
+    // so the result doesn't depend on the order the grid gave them to us
+    collisions.clear();
+    if (overlaps.Sweep(asteroids.GetCircles(), projectiles.GetCircles(), 1) > 0)
     {
-        // Move the projectiles
-        projectiles[i]->Advance(elapsedTime);
-        if (projectiles[i]->IsOut())
+        for (int p = 0; p < overlaps.GetCount(); p++)
         {
-            // Eliminate the projectile from the list if it's outside the screen
-            Projectile* projectile = projectiles[i];
-            for (int j = i; j < noProjectiles - 1; j++)
+            if (!overlaps.IsHit(p))
             {
-                projectiles[j] = projectiles[j + 1];
+                continue;
             }
-            projectiles[noProjectiles - 1] = NULL;
-            delete projectile;
-            noProjectiles--;
-            i--;
+
+            int j = overlapProjectiles[p];
+            Point2D start = projectiles.GetPreviousPosition(j);
+            Point2D end = projectiles.GetPosition(j);
+            ProjectileCollision collision;
+            collision.asteroid = overlaps.GetFirst(p);
+            collision.projectile = j;
+            collision.time = asteroids.FirstContact(collision.asteroid,
+                ScalarFromDouble(start.x), ScalarFromDouble(start.y), ScalarFromDouble(end.x), ScalarFromDouble(end.y));
+            if (collision.time >= 0)
+            {
+                collisions.push_back(collision);
+            }
+        }
+    }
+    std::sort(collisions.begin(), collisions.end());
+
+    // Each asteroid takes the first projectile that reaches it, and each projectile stops at the first asteroid in its way
+    asteroidHit.assign(asteroids.GetCount(), 0);
+    projectileHit.assign(projectiles.GetCount(), 0);
+    for (size_t p = 0; p < collisions.size(); p++)
+    {
+        int i = collisions[p].asteroid;
+        int j = collisions[p].projectile;
+        if (!asteroidHit[i] && !projectileHit[j])
+        {
+            asteroidHit[i] = 1;
+            projectileHit[j] = 1;
         }
     }
 
-    // Asteroid logic
-    for (int i = 0; i < noAsteroids; i++)
+    if (!collisions.empty())
     {
-        // Move the asteroids
-        asteroids[i]->Advance(elapsedTime);
-        if (asteroids[i]->GetSize() == 0 && asteroids[i]->GetExplosionTime() > 0.5)
+        // Eliminate the projectiles that hit something
+        for (int j = 0; j < projectiles.GetCount(); j++)
         {
-            // If the asteroid is exploded and 0.5 seconds passed, we remove the asteroid from the list
-            Asteroid* asteroid = asteroids[i];
-            for (int k = i; k < noAsteroids - 1; k++)
+            if (projectileHit[j])
             {
-                asteroids[k] = asteroids[k + 1];
+                projectiles.Remove(j);
             }
-            asteroids[noAsteroids - 1] = NULL;
-            delete asteroid;
-            noAsteroids--;
+        }
 
-            if (noAsteroids == 0)
+        // The asteroids that were hit are destroyed: the big ones split into 2 smaller ones, the smallest ones burst into debris
+        destroyedAsteroids.clear();
+        for (int i = asteroids.GetCount() - 1; i >= 0; i--)
+        {
+            if (asteroidHit[i])
             {
-                // You won!
-                gameOver = true;
-                gameWon = true;
+                destroyedAsteroids.push_back(i);
             }
         }
-    }
 
-    // Projectile to asteroid collisions
-    bool foundCollision = false;
-    // We go through each asteroid and projectile to check for collisions
-    for (int i = 0; i < noAsteroids; i++)
-    {
-        for (int j = 0; j < noProjectiles; j++)
+        // The new asteroids are created in increasing order of their parent, so the game stays reproducible.
+        // Nothing is removed yet, so the parents are still where they were
+        for (int k = (int)destroyedAsteroids.size() - 1; k >= 0; k--)
         {
-            if (!foundCollision) // One collision detection per frame is enough
+            int i = destroyedAsteroids[k];
+            Point2D cSpeed = asteroids.GetSpeed(i);
+            Point2D cPosition = asteroids.GetPosition(i);
+            int newSize = asteroids.GetSize(i) / 2;
+
+            if (newSize == 0)
             {
-                Projectile* projectile = projectiles[j];
-                Asteroid* asteroid = asteroids[i];
-
-                // Distance between the center of the asteroid and projectile
-                double distance = pow(asteroid->GetPosition().x - projectile->GetPosition().x, 2) + pow(asteroid->GetPosition().y - projectile->GetPosition().y, 2);
-                // Size of the asteroid
-                double size = pow(asteroid->GetSize() * ASTEROID_SIZE_MULTIPLIER, 2) * 1.2;
-
-                if (distance < size)
-                { // We have a collision
-
-                    // Eliminate projectile
-                    for (int k = j; k < noProjectiles - 1; k++)
-                    {
-                        projectiles[k] = projectiles[k + 1];
-                    }
-                    projectiles[noProjectiles - 1] = NULL;
-                    delete projectile;
-                    noProjectiles--;
-
-                    // Explode asteroid and create 2 new if needed
-                    if (asteroid->GetSize() > 1)
-                    {
-                        // If the asteroid's size is higher than 1, we can split it into 2
-                        // That means creating 2 smaller asteroids and removing this one
-                        Point2D cSpeed = asteroid->GetSpeed();
-
-                        // New asteroid 1
-                        Point2D newSpeed1;
-                        newSpeed1.x = cSpeed.y * 1.5;
-                        newSpeed1.y = cSpeed.x * 1.5;
-                        Asteroid* newAsteroid1 = new Asteroid(asteroid->GetPosition(), asteroid->GetSize() / 2, newSpeed1);
-                        newAsteroid1->InitializeD2D(m_pRenderTarget);
-                        asteroids[noAsteroids] = newAsteroid1;
-                        noAsteroids++;
-
-                        // New asteroid 2
-                        Point2D newSpeed2;
-                        newSpeed2.x = -cSpeed.y * 1.5;
-                        newSpeed2.y = -cSpeed.x * 1.5;
-                        Asteroid* newAsteroid2 = new Asteroid(asteroid->GetPosition(), asteroid->GetSize() / 2, newSpeed2);
-                        newAsteroid2->InitializeD2D(m_pRenderTarget);
-                        asteroids[noAsteroids] = newAsteroid2;
-                        noAsteroids++;
-
-                        // Remove old asteroid
-                        for (int k = i; k < noAsteroids - 1; k++)
-                        {
-                            asteroids[k] = asteroids[k + 1];
-                        }
-                        asteroids[noAsteroids - 1] = NULL;
-                        delete asteroid;
-                        noAsteroids--;
-                    }
-                    else
-                    {
-                        // If atseroid size was 1, we set it to explosion mode
-                        asteroid->Explode();
-                    }
-                    
-                    foundCollision = true;
+                // One piece of debris per corner, the bumpier the corner the faster it goes
+                Scalar speeds[ASTEROID_CORNERS];
+                for (int c = 0; c < ASTEROID_CORNERS; c++)
+                {
+                    speeds[c] = 100 + 20 * asteroids.GetSizeVariation(i, c);
                 }
+                particles.SpawnBurst(PARTICLE_ASTEROID, ScalarFromDouble(cPosition.x), ScalarFromDouble(cPosition.y), speeds, ASTEROID_CORNERS);
+                PublishEvent(GAME_EVENT_ASTEROID_DESTROYED, cPosition, asteroids.GetSize(i));
+                continue;
             }
+            PublishEvent(GAME_EVENT_ASTEROID_SPLIT, cPosition, asteroids.GetSize(i));
+
+            // New asteroid 1
+            Point2D newSpeed1;
+            newSpeed1.x = cSpeed.y * 1.5;
+            newSpeed1.y = cSpeed.x * 1.5;
+            asteroids.Spawn(random, cPosition, newSize, newSpeed1);
+
+            // New asteroid 2
+            Point2D newSpeed2;
+            newSpeed2.x = -cSpeed.y * 1.5;
+            newSpeed2.y = -cSpeed.x * 1.5;
+            asteroids.Spawn(random, cPosition, newSize, newSpeed2);
+        }
+
+        // Remove old asteroids, backwards so the indices we still need don't move.
+        // They're out of the game right away, the debris is only for show
+        for (size_t k = 0; k < destroyedAsteroids.size(); k++)
+        {
+            asteroids.Remove(destroyedAsteroids[k]);
+        }
+
+        if (asteroids.GetCount() == 0)
+        {
+            // You won!
+            PublishEvent(GAME_EVENT_GAME_WON, ship->GetPosition(), 0);
+            gameOver = true;
+            gameWon = true;
         }
-    }
 
+        // The asteroids changed, so the grid has to be rebuilt for the ship
+        BuildAsteroidGrid();
+    }
+    projectiles.Expire();
+    EndPhase(PHASE_PROJECTILE_COLLISIONS);
 
     // Ship to asteroid collisions
     // If the ship is already exploded, it doesn't matter
     if (!ship->IsExploded())
     {
-        foundCollision = false;
-        // We go through all the steroids
-        for (int i = 0; i < noAsteroids; i++)
+        // We only go through the asteroids near the ship's path this tick, with bounding circles touching the ship's along the way.
+        // Those are then checked against the ship's triangle where it is now
+        Point2D shipPosition = ship->GetPosition();
+        Point2D shipPreviousPosition = ship->GetPreviousPosition();
+        Scalar shipX = ScalarFromDouble(shipPosition.x);
+        Scalar shipY = ScalarFromDouble(shipPosition.y);
+        Scalar shipPreviousX = ScalarFromDouble(shipPreviousPosition.x);
+        Scalar shipPreviousY = ScalarFromDouble(shipPreviousPosition.y);
+        Scalar shipRadius = SHIP_RADIUS;
+        CircleSet shipCircle;
+        shipCircle.x = &shipX;
+        shipCircle.y = &shipY;
+        shipCircle.radius = &shipRadius;
+        shipCircle.previousX = &shipPreviousX;
+        shipCircle.previousY = &shipPreviousY;
+
+        double pathRadius;
+        Point2D pathCenter = GetPathBox(shipPreviousPosition, shipPosition, pathRadius);
+        grid.Query(pathCenter, pathRadius + SHIP_RADIUS, candidates);
+        overlaps.Clear();
+        for (size_t c = 0; c < candidates.size(); c++)
         {
-            if (!foundCollision) // One collision per frame is enough
-            {
-                Asteroid* asteroid = asteroids[i];
-
-                // Distance between ship's and asteroid's centers
-                double distance = pow(asteroid->GetPosition().x - ship->GetPosition().x, 2) + pow(asteroid->GetPosition().y - ship->GetPosition().y, 2);
-                // Asteroid's size + ship's size
-                double size = pow(asteroid->GetSize() * ASTEROID_SIZE_MULTIPLIER + 5, 2);
+            overlaps.Add(candidates[c], 0);
+        }
 
-                // If we have a collision
-                if (distance < size)
+        // If we have a collision: ship explosion
+        if (overlaps.Sweep(asteroids.GetCircles(), shipCircle, 1) > 0)
+        {
+            bool hit = false;
+            for (int p = 0; p < overlaps.GetCount() && !hit; p++)
+            {
+                if (overlaps.IsHit(p))
                 {
-                    // Ship explosion
-                    ship->Explode();
-
-                    foundCollision = true;
+                    hit = ShipHitsAsteroid(overlaps.GetFirst(p), overlaps.GetTime(p));
                 }
             }
+            if (hit)
+            {
+                ExplodeShip();
+            }
         }
     }
+    EndPhase(PHASE_SHIP_COLLISIONS);
+}
 
+bool Engine::ShipHitsAsteroid(int asteroid, Scalar contactTime)
+{
+    // The bounding circles first touch at contactTime, so the triangle can't hit the outline any earlier.
+    // From there to the end of the tick, the triangle is tested in as many poses as it takes for neither of them
+    // to move more than SHIP_SWEEP_STEP pixels between two poses, so it can't jump over a corner of the outline
+    Point2D shipStart = ship->GetPreviousPosition();
+    Point2D shipEnd = ship->GetPosition();
+    Point2D asteroidStart = asteroids.GetPreviousPosition(asteroid);
+    Point2D asteroidEnd = asteroids.GetPosition(asteroid);
+    // The nose moves the most when the ship turns: a little under a 57th of its length per degree
+    double turn = fabs(ship->GetRotation() - ship->GetPreviousRotation()) * SHIP_NOSE_LENGTH / 57;
+    double travel = std::max(fabs(shipEnd.x - shipStart.x) + fabs(shipEnd.y - shipStart.y) + turn,
+        fabs(asteroidEnd.x - asteroidStart.x) + fabs(asteroidEnd.y - asteroidStart.y));
+    int steps = 1 + (int)(ScalarToDouble(1 - contactTime) * travel / SHIP_SWEEP_STEP);
+
+    Scalar triangleX[3];
+    Scalar triangleY[3];
+    for (int k = 0; k <= steps; k++)
+    {
+        Scalar time = contactTime + (1 - contactTime) * k / steps;
+        ship->GetTriangle(time, triangleX, triangleY);
+        if (asteroids.OverlapsTriangle(asteroid, time, triangleX, triangleY))
+        {
+            return true;
+        }
+    }
+    return false;
 }
 
-HRESULT Engine::Draw()
+void Engine::ExplodeShip()
 {
-    // This is the drawing method of the engine.
-    // It simply draws all the elements in the game using Direct2D
-    HRESULT hr;
+    // The ship is out until it respawns, SHIP_RESPAWN_TIME later.
+    // Its debris flies away at the same speed in every direction
+    ship->Explode();
+    PublishEvent(GAME_EVENT_SHIP_DESTROYED, ship->GetPosition(), 0);
+    timers.Schedule(tick + respawnTicks, TIMER_SHIP_RESPAWN, 0);
+    Point2D position = ship->GetPosition();
+    Scalar speeds[ASTEROID_CORNERS];
+    for (int i = 0; i < ASTEROID_CORNERS; i++)
+    {
+        speeds[i] = 120;
+    }
+    particles.SpawnBurst(PARTICLE_SHIP, ScalarFromDouble(position.x), ScalarFromDouble(position.y), speeds, ASTEROID_CORNERS);
+}
 
-    m_pRenderTarget->BeginDraw();
+void Engine::HandleTimer(const Timer& timer)
+{
+    switch (timer.type)
+    {
+    case TIMER_SHIP_RESPAWN:
+        // Timers can't be cancelled, so this one may not apply anymore: nothing comes back once the game is over,
+        // and a ship that isn't exploded has nothing to come back from
+        if (gameOver || !ship->IsExploded())
+        {
+            break;
+        }
 
-    m_pRenderTarget->SetTransform(D2D1::Matrix3x2F::Identity());
+        // Coming back costs a life
+        lives--;
+        if (lives < 0)
+        {
+            // Game Over. The ship stays exploded, so nothing can hit it anymore
+            PublishEvent(GAME_EVENT_GAME_LOST, ship->GetPosition(), 0);
+            gameOver = true;
+            gameWon = false;
+            break;
+        }
 
+        // The ship comes back in the center
+        ship->Reset();
+        PublishEvent(GAME_EVENT_LIFE_LOST, ship->GetPosition(), lives);
+        break;
+    }
+}
 
-    m_pRenderTarget->Clear(D2D1::ColorF(D2D1::ColorF::Black));
+void Engine::PublishEvent(GameEventType type, Point2D position, int data)
+{
+    // The game goes on after it's over, but nothing that happens then counts: the end of the game is its last event
+    if (gameOver)
+    {
+        return;
+    }
+    events.Publish(type, tick, position, data);
+}
 
-    // Draws all the projectiles
-    for (int i = 0; i < noProjectiles; i++)
+void Engine::EndPhase(EnginePhase phase)
+{
+    if (profile == NULL && !tracePhases)
     {
-        projectiles[i]->Draw(m_pRenderTarget);
+        return;
     }
 
-    if (!gameOver || gameWon)
+    // Each phase ends where the next one starts, so the whole tick is accounted for
+    long long now = Trace::Now();
+    if (profile != NULL)
+    {
+        profile->nanoseconds[phase] += now - phaseStart;
+    }
+    if (tracePhases)
     {
-        // Draws the ship only if it's not game over
-        ship->Draw(m_pRenderTarget);
+        Trace::Record(EngineProfile::GetPhaseName(phase), phaseStart, now);
     }
+    phaseStart = now;
+}
 
-    // Draws the asteroids
-    for (int i = 0; i < noAsteroids; i++)
+void Engine::BuildAsteroidGrid()
+{
+    // Every asteroid goes in the cells covered by its bounding circle all along its path this tick
+    grid.Clear();
+    for (int i = 0; i < asteroids.GetCount(); i++)
     {
-        asteroids[i]->Draw(m_pRenderTarget);
+        double pathRadius;
+        Point2D pathCenter = GetPathBox(asteroids.GetPreviousPosition(i), asteroids.GetPosition(i), pathRadius);
+        grid.Insert(i, pathCenter, pathRadius + asteroids.GetOutlineRadius(i));
     }
+}
+
+void Engine::WriteSnapshot(RenderSnapshot* snapshot)
+{
+    snapshot->ship = *ship;
+    snapshot->projectiles = projectiles;
+    snapshot->asteroids = asteroids;
+    snapshot->particles = particles;
+    snapshot->lives = lives;
+    snapshot->gameOver = gameOver;
+    snapshot->gameWon = gameWon;
+}
 
-    // Draws the "lives" ships
-    for (int i = 0; i < lives; i++)
+void Engine::WriteState(StateWriter& writer)
+{
+    // Only the game itself is saved. The grid and the scratch buffers are rebuilt every tick
+    writer.Write((uint32_t)ENGINE_STATE_MAGIC);
+    writer.Write((uint32_t)ENGINE_STATE_VERSION);
+    writer.Write((uint32_t)ENGINE_STATE_SCALAR);
+    writer.Write(seed);
+    writer.Write(random.GetState());
+    writer.Write(tick);
+    writer.Write(lives);
+    writer.Write(leftPressed);
+    writer.Write(rightPressed);
+    writer.Write(accelerationPressed);
+    writer.Write(firePressed);
+    writer.Write(leftHeld);
+    writer.Write(rightHeld);
+    writer.Write(accelerationHeld);
+    writer.Write(gameOver);
+    writer.Write(gameWon);
+
+    ship->SaveState(writer);
+    projectiles.SaveState(writer);
+    asteroids.SaveState(writer);
+    particles.SaveState(writer);
+    timers.SaveState(writer);
+}
+
+size_t Engine::GetStateSize()
+{
+    // Writing to nowhere only counts the bytes
+    StateWriter writer(NULL);
+    WriteState(writer);
+    return writer.GetSize();
+}
+
+size_t Engine::SaveState(void* buffer, size_t bufferSize)
+{
+    if (bufferSize < GetStateSize())
     {
-        lifeShips[i]->Draw(m_pRenderTarget);
+        return 0;
     }
 
-    // Game Over: we draw the "Game Over" or "You Win" texts
-    if (gameOver)
+    StateWriter writer(buffer);
+    WriteState(writer);
+    return writer.GetSize();
+}
+
+bool Engine::LoadState(const void* buffer, size_t size)
+{
+    StateReader reader(buffer, size);
+
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint32_t scalar = 0;
+    reader.Read(magic);
+    reader.Read(version);
+    reader.Read(scalar);
+    if (!reader.IsValid() || magic != ENGINE_STATE_MAGIC || version != ENGINE_STATE_VERSION || scalar != ENGINE_STATE_SCALAR)
     {
-        D2D1_RECT_F rectangle2 = D2D1::RectF(0, 0, RESOLUTION_X, RESOLUTION_X);
+        NewGame(seed);
+        return false;
+    }
 
-        if (gameWon)
-        {
-            m_pRenderTarget->DrawText(
-                L"You Win!",
-                8,
-                m_pTextFormat,
-                rectangle2,
-                m_pWhiteBrush
-            );
-        }
-        else
-        {
-            m_pRenderTarget->DrawText(
-                L"Game Over!",
-                10,
-                m_pTextFormat,
-                rectangle2,
-                m_pWhiteBrush
-            );
-        }
-        
+    uint64_t randomState = 0;
+    reader.Read(seed);
+    reader.Read(randomState);
+    random.SetState(randomState);
+    reader.Read(tick);
+    reader.Read(lives);
+    reader.Read(leftPressed);
+    reader.Read(rightPressed);
+    reader.Read(accelerationPressed);
+    reader.Read(firePressed);
+    reader.Read(leftHeld);
+    reader.Read(rightHeld);
+    reader.Read(accelerationHeld);
+    reader.Read(gameOver);
+    reader.Read(gameWon);
+
+    ship->LoadState(reader);
+    projectiles.LoadState(reader);
+    asteroids.LoadState(reader);
+    particles.LoadState(reader);
+    timers.LoadState(reader);
+
+    if (!reader.IsValid())
+    {
+        // Half of a state is not a game, start over instead
+        NewGame(seed);
+        return false;
     }
-    
-    hr = m_pRenderTarget->EndDraw();
+    return true;
+}
+
+void Engine::SetInputRecording(InputRecording* newRecording)
+{
+    recording = newRecording;
+}
+
+void Engine::SetProfile(EngineProfile* newProfile)
+{
+    profile = newProfile;
+}
+
+Ship* Engine::GetShip()
+{
+    return ship;
+}
 
-    return S_OK;
+ProjectileField* Engine::GetProjectiles()
+{
+    return &projectiles;
+}
+
+AsteroidField* Engine::GetAsteroids()
+{
+    return &asteroids;
+}
+
+ParticlePool* Engine::GetParticles()
+{
+    return &particles;
+}
+
+GameEventLog* Engine::GetEvents()
+{
+    return &events;
+}
+
+uint64_t Engine::GetSeed()
+{
+    return seed;
+}
+
+long long Engine::GetTick()
+{
+    return tick;
+}
+
+int Engine::GetLives()
+{
+    return lives;
+}
+
+bool Engine::IsGameOver()
+{
+    return gameOver;
+}
+
+bool Engine::IsGameWon()
+{
+    return gameWon;
 }
\ No newline at end of file
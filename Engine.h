@@ -1,48 +1,211 @@
 #pragma once
 
-#include "resource.h"
+#include <vector>
+#include "Keys.h"
+#include "Random.h"
+#include "StateBuffer.h"
+#include "World.h"
+#include "SpatialGrid.h"
 #include "Ship.h"
 #include "Projectile.h"
 #include "Asteroid.h"
+#include "Particle.h"
+#include "TimerWheel.h"
+#include "GameEvent.h"
+#include "RenderSnapshot.h"
+#include "InputRecording.h"
+#include "Trace.h"
 
-#define RESOLUTION_X 800
-#define RESOLUTION_Y 600
-#define PI 3.14159265
+// Collision grid cells are as big as the radius of the biggest asteroid
+#define GRID_CELL_SIZE (ASTEROID_SIZE_MULTIPLIER * 4)
+
+// Most pixels the ship or an asteroid moves between two of the poses the ship's triangle is tested in
+#define SHIP_SWEEP_STEP 5
+
+// Marks the start of a saved state. The version changes whenever the layout does
+#define ENGINE_STATE_MAGIC 0x41535445
+#define ENGINE_STATE_VERSION 6
+// The physics numbers are saved as they are, so states only load in builds with the same Scalar (see Scalar.h)
+#ifdef ASTEROIDS_FIXED_POINT
+#define ENGINE_STATE_SCALAR 1
+#else
+#define ENGINE_STATE_SCALAR 0
+#endif
+
+// Tunable rules of the game. The defaults play like the original game
+struct EngineConfig
+{
+	EngineConfig();
+
+	// How many projectiles can be on the screen at the same time
+	int maxProjectiles;
+	// Projectiles disappear after this many seconds, or after travelling this many pixels
+	double projectileTimeToLive;
+	double projectileRange;
+
+	// Seed of the first game
+	uint64_t seed;
+
+	// Length of the ticks Logic is meant to be run with, in seconds. Delays, like the ship's respawn, are turned into
+	// a number of ticks of this length once, so they don't depend on how long the tick they started in was
+	double tickTime;
+};
+
+// What the engine's timers are for (Timer::type)
+enum EngineTimer
+{
+	// The exploded ship comes back for its next life
+	TIMER_SHIP_RESPAWN
+};
+
+// The parts of a tick, in the order Logic runs them
+enum EnginePhase
+{
+	PHASE_TIMERS,
+	PHASE_INPUT,
+	PHASE_SHIP,
+	PHASE_PROJECTILES,
+	PHASE_ASTEROIDS,
+	PHASE_PARTICLES,
+	PHASE_BROADPHASE,
+	PHASE_PROJECTILE_COLLISIONS,
+	PHASE_SHIP_COLLISIONS,
+	PHASE_COUNT
+};
+
+// Time spent in each phase of Logic, added up over the ticks run while it was attached to an engine.
+// While tracing is on, the phases also show up as trace spans under these names
+struct EngineProfile
+{
+	EngineProfile();
+	void Reset();
+	static const char* GetPhaseName(int phase);
+
+	long long ticks;
+	long long nanoseconds[PHASE_COUNT];
+};
+
+// A projectile hitting an asteroid during a tick. They're sorted by when it happened, then by asteroid and projectile
+struct ProjectileCollision
+{
+	Scalar time;
+	int asteroid;
+	int projectile;
+
+	bool operator<(const ProjectileCollision& other) const
+	{
+		if (time != other.time)
+			return time < other.time;
+		if (asteroid != other.asteroid)
+			return asteroid < other.asteroid;
+		return projectile < other.projectile;
+	}
+};
 
 class Engine
 {
 public:
 	Engine();
+	Engine(const EngineConfig& config);
 	~Engine();
 
-	HRESULT InitializeD2D(HWND m_hwnd);
-	void KeyUp(WPARAM wParam);
-	void KeyDown(WPARAM wParam);
+	// Starts a new game. Two engines started with the same seed and given the same input play exactly the same game
+	void NewGame(uint64_t newSeed);
+
+	// Key changes that happen before the next tick
+	void KeyUp(unsigned int key);
+	void KeyDown(unsigned int key);
+	// Key changes partway through the next tick, offset going from 0 (at its start) to 1 (at its end).
+	// A key held for part of a tick only turns or thrusts the ship for that part
+	void KeyUp(unsigned int key, double offset);
+	void KeyDown(unsigned int key, double offset);
 	void Logic(double elapsedTime);
-	HRESULT Draw();
+
+	// Every new game and key from now on also goes into the recording. NULL stops recording
+	void SetInputRecording(InputRecording* newRecording);
+	// Times every phase of Logic into the profile. NULL stops it, and then timing costs nothing
+	void SetProfile(EngineProfile* newProfile);
+
+	// Read-only access to the game state, used by the renderer and the headless tools
+	uint64_t GetSeed();
+	// Ticks played since the game started
+	long long GetTick();
+	Ship* GetShip();
+	ProjectileField* GetProjectiles();
+	AsteroidField* GetAsteroids();
+	ParticlePool* GetParticles();
+	int GetLives();
+	bool IsGameOver();
+	bool IsGameWon();
+	// What happened in the game, for readers that would rather not compare whole states every frame.
+	// The events aren't part of the saved state: loading one neither takes them back nor plays them again
+	GameEventLog* GetEvents();
+
+	// Copies what the renderer needs. Doesn't change the snapshot's tick time or publish time
+	void WriteSnapshot(RenderSnapshot* snapshot);
+
+	// Snapshot of the whole game in one flat buffer, to rewind or fork a game.
+	// The size changes with the number of asteroids. SaveState returns the bytes written, or 0 if the buffer is too small.
+	// LoadState only accepts states saved by an engine with the same configuration; if it fails, a new game is started
+	size_t GetStateSize();
+	size_t SaveState(void* buffer, size_t bufferSize);
+	bool LoadState(const void* buffer, size_t size);
 
 private:
-	ID2D1Factory* m_pDirect2dFactory;
-	ID2D1HwndRenderTarget* m_pRenderTarget;
+	void BuildAsteroidGrid();
+	// True if the ship's triangle overlaps the asteroid's outline at some time between contactTime and the end of the tick
+	bool ShipHitsAsteroid(int asteroid, Scalar contactTime);
+	void ExplodeShip();
+	void HandleTimer(const Timer& timer);
+	void PublishEvent(GameEventType type, Point2D position, int data);
+	static int QuantizeOffset(double offset);
+	static long long GetDelayTicks(double seconds, double tickTime);
+	void EndPhase(EnginePhase phase);
+	void WriteState(StateWriter& writer);
 
-	IDWriteFactory* m_pDWriteFactory;
-	IDWriteTextFormat* m_pTextFormat;
-	ID2D1SolidColorBrush* m_pWhiteBrush;
+	EngineConfig config;
+	uint64_t seed;
+	Random random;
+	long long tick;
+	InputRecording* recording;
+	EngineProfile* profile;
+	long long phaseStart;
+	// Whether this tick's phases go into the trace, decided once per tick
+	bool tracePhases;
 
 	Ship* ship;
-	Projectile* projectiles[20];
-	int noProjectiles;
-	Asteroid* asteroids[32];
-	int noAsteroids;
+	ProjectileField projectiles;
+	AsteroidField asteroids;
+	ParticlePool particles;
+	// Everything that happens after a delay, keyed on the tick
+	TimerWheel timers;
+	// Ticks between the ship exploding and respawning, from config.tickTime
+	long long respawnTicks;
+	GameEventLog events;
 	int lives;
-	Ship* lifeShips[3];
 
 	bool leftPressed;
 	bool rightPressed;
 	bool accelerationPressed;
+	// 0: up, 1: down and not fired yet, 2: fired, waiting for release, 3: released before it could fire
 	int firePressed;
+	// Part of the next tick each key is held for
+	double leftHeld;
+	double rightHeld;
+	double accelerationHeld;
 
 	bool gameOver;
 	bool gameWon;
-};
 
+	// Collision broadphase and scratch buffers, kept between ticks so they don't reallocate
+	SpatialGrid grid;
+	std::vector<int> candidates;
+	OverlapBatch overlaps;
+	// Index of the projectile of each pair in overlaps, which only knows its slot
+	std::vector<int> overlapProjectiles;
+	std::vector<ProjectileCollision> collisions;
+	std::vector<char> asteroidHit;
+	std::vector<char> projectileHit;
+	std::vector<int> destroyedAsteroids;
+	std::vector<Timer> firedTimers;
+};
@@ -0,0 +1,340 @@
+#pragma once
+
+#include <vector>
+#include "StateBuffer.h"
+#include "Motion.h"
+
+// Reference to an entity that stays valid while other entities are added and removed.
+// When the entity is removed its slot gets a new generation, so old handles simply stop resolving
+struct EntityHandle
+{
+	unsigned int slot;
+	unsigned int generation;
+};
+
+// For entity kinds that don't need anything besides the common components
+struct NoPayload
+{
+};
+
+// Contiguous component storage for one kind of entity.
+// Every component is a tightly packed array indexed by the entity's dense index, so loops over all entities
+// walk memory linearly. Removing an entity moves the last one into its place (swap and pop), nothing ever shifts.
+// Dense indices change on removal; keep an EntityHandle to refer to an entity across removals
+template<typename Payload>
+class EntityStore
+{
+public:
+	// Transform
+	std::vector<Scalar> x;
+	std::vector<Scalar> y;
+	std::vector<Scalar> rotation;
+
+	// Transform at the start of the last tick, so drawing can interpolate between the last two states
+	std::vector<Scalar> previousX;
+	std::vector<Scalar> previousY;
+	std::vector<Scalar> previousRotation;
+
+	// Velocity
+	std::vector<Scalar> speedX;
+	std::vector<Scalar> speedY;
+	std::vector<Scalar> rotationSpeed;
+
+	// Collider
+	std::vector<Scalar> radius;
+
+	// Lifetime: seconds since the entity entered its current state
+	std::vector<Scalar> age;
+
+	// Data specific to this kind of entity
+	std::vector<Payload> payload;
+
+	int Count() const
+	{
+		return (int)x.size();
+	}
+
+	void Reserve(int capacity)
+	{
+		x.reserve(capacity);
+		y.reserve(capacity);
+		rotation.reserve(capacity);
+		previousX.reserve(capacity);
+		previousY.reserve(capacity);
+		previousRotation.reserve(capacity);
+		speedX.reserve(capacity);
+		speedY.reserve(capacity);
+		rotationSpeed.reserve(capacity);
+		radius.reserve(capacity);
+		age.reserve(capacity);
+		payload.reserve(capacity);
+		slotOf.reserve(capacity);
+		indexOfSlot.reserve(capacity);
+		generations.reserve(capacity);
+		freeSlots.reserve(capacity);
+	}
+
+	// Adds an entity with all its components zeroed, at dense index Count() - 1
+	EntityHandle Add()
+	{
+		unsigned int slot;
+		if (!freeSlots.empty())
+		{
+			slot = freeSlots.back();
+			freeSlots.pop_back();
+		}
+		else
+		{
+			slot = (unsigned int)generations.size();
+			generations.push_back(0);
+			indexOfSlot.push_back(0);
+		}
+
+		indexOfSlot[slot] = (unsigned int)x.size();
+		slotOf.push_back(slot);
+
+		x.push_back(0);
+		y.push_back(0);
+		rotation.push_back(0);
+		previousX.push_back(0);
+		previousY.push_back(0);
+		previousRotation.push_back(0);
+		speedX.push_back(0);
+		speedY.push_back(0);
+		rotationSpeed.push_back(0);
+		radius.push_back(0);
+		age.push_back(0);
+		payload.push_back(Payload());
+
+		EntityHandle handle;
+		handle.slot = slot;
+		handle.generation = generations[slot];
+		return handle;
+	}
+
+	// Removes the entity at this dense index; the last entity takes its place
+	void Remove(int index)
+	{
+		int last = Count() - 1;
+		unsigned int slot = slotOf[index];
+
+		if (index != last)
+		{
+			x[index] = x[last];
+			y[index] = y[last];
+			rotation[index] = rotation[last];
+			previousX[index] = previousX[last];
+			previousY[index] = previousY[last];
+			previousRotation[index] = previousRotation[last];
+			speedX[index] = speedX[last];
+			speedY[index] = speedY[last];
+			rotationSpeed[index] = rotationSpeed[last];
+			radius[index] = radius[last];
+			age[index] = age[last];
+			payload[index] = payload[last];
+			slotOf[index] = slotOf[last];
+			indexOfSlot[slotOf[index]] = index;
+		}
+
+		x.pop_back();
+		y.pop_back();
+		rotation.pop_back();
+		previousX.pop_back();
+		previousY.pop_back();
+		previousRotation.pop_back();
+		speedX.pop_back();
+		speedY.pop_back();
+		rotationSpeed.pop_back();
+		radius.pop_back();
+		age.pop_back();
+		payload.pop_back();
+		slotOf.pop_back();
+
+		// Invalidates every handle to the removed entity
+		generations[slot]++;
+		freeSlots.push_back(slot);
+	}
+
+	void Clear()
+	{
+		while (Count() > 0)
+		{
+			Remove(Count() - 1);
+		}
+	}
+
+	EntityHandle HandleOf(int index) const
+	{
+		EntityHandle handle;
+		handle.slot = slotOf[index];
+		handle.generation = generations[handle.slot];
+		return handle;
+	}
+
+	// Dense index of the entity, or -1 if it has been removed
+	int IndexOf(EntityHandle handle) const
+	{
+		if (handle.slot >= generations.size() || generations[handle.slot] != handle.generation)
+		{
+			return -1;
+		}
+		return (int)indexOfSlot[handle.slot];
+	}
+
+	bool IsValid(EntityHandle handle) const
+	{
+		return IndexOf(handle) >= 0;
+	}
+
+	// Makes the previous transform the same as the current one, for entities that just appeared or teleported
+	void ResetPrevious(int index)
+	{
+		previousX[index] = x[index];
+		previousY[index] = y[index];
+		previousRotation[index] = rotation[index];
+	}
+
+	// Moves and rotates every entity according to its velocity, remembering where it was.
+	// With wrap, entities that leave the screen come back on the other side. One pass over all of them, see IntegrateMotion
+	void Integrate(Scalar elapsedTime, bool wrap)
+	{
+		MotionArrays arrays;
+		arrays.x = x.data();
+		arrays.y = y.data();
+		arrays.rotation = rotation.data();
+		arrays.previousX = previousX.data();
+		arrays.previousY = previousY.data();
+		arrays.previousRotation = previousRotation.data();
+		arrays.speedX = speedX.data();
+		arrays.speedY = speedY.data();
+		arrays.rotationSpeed = rotationSpeed.data();
+		arrays.age = age.data();
+		IntegrateMotion(arrays, Count(), elapsedTime, wrap);
+	}
+
+	// Writes every component and the handle bookkeeping as flat arrays
+	void SaveState(StateWriter& writer) const
+	{
+		unsigned int count = (unsigned int)x.size();
+		unsigned int slotCount = (unsigned int)generations.size();
+		unsigned int freeCount = (unsigned int)freeSlots.size();
+		writer.Write(count);
+		writer.Write(slotCount);
+		writer.Write(freeCount);
+
+		writer.WriteArray(x.data(), count);
+		writer.WriteArray(y.data(), count);
+		writer.WriteArray(rotation.data(), count);
+		writer.WriteArray(previousX.data(), count);
+		writer.WriteArray(previousY.data(), count);
+		writer.WriteArray(previousRotation.data(), count);
+		writer.WriteArray(speedX.data(), count);
+		writer.WriteArray(speedY.data(), count);
+		writer.WriteArray(rotationSpeed.data(), count);
+		writer.WriteArray(radius.data(), count);
+		writer.WriteArray(age.data(), count);
+		writer.WriteArray(payload.data(), count);
+		writer.WriteArray(slotOf.data(), count);
+		writer.WriteArray(indexOfSlot.data(), slotCount);
+		writer.WriteArray(generations.data(), slotCount);
+		writer.WriteArray(freeSlots.data(), freeCount);
+	}
+
+	void LoadState(StateReader& reader)
+	{
+		unsigned int count = 0;
+		unsigned int slotCount = 0;
+		unsigned int freeCount = 0;
+		reader.Read(count);
+		reader.Read(slotCount);
+		reader.Read(freeCount);
+		// Every entity and slot takes more than a byte, so counts past what's left can't be real, and would only allocate for nothing
+		if (!reader.IsValid() || count > slotCount || freeCount > slotCount || slotCount > reader.GetRemaining())
+		{
+			reader.Fail();
+			return;
+		}
+
+		// Resizing only allocates if this store never held that many entities
+		ResizeComponents(count);
+		indexOfSlot.resize(slotCount);
+		generations.resize(slotCount);
+		freeSlots.resize(freeCount);
+
+		reader.ReadArray(x.data(), count);
+		reader.ReadArray(y.data(), count);
+		reader.ReadArray(rotation.data(), count);
+		reader.ReadArray(previousX.data(), count);
+		reader.ReadArray(previousY.data(), count);
+		reader.ReadArray(previousRotation.data(), count);
+		reader.ReadArray(speedX.data(), count);
+		reader.ReadArray(speedY.data(), count);
+		reader.ReadArray(rotationSpeed.data(), count);
+		reader.ReadArray(radius.data(), count);
+		reader.ReadArray(age.data(), count);
+		reader.ReadArray(payload.data(), count);
+		reader.ReadArray(slotOf.data(), count);
+		reader.ReadArray(indexOfSlot.data(), slotCount);
+		reader.ReadArray(generations.data(), slotCount);
+		reader.ReadArray(freeSlots.data(), freeCount);
+
+		// Every slot is either used by exactly one entity that points back to it, or free, and listed only once.
+		// Anything else would send Remove and IndexOf outside the arrays, or let Add hand out a slot that's taken
+		bool valid = reader.IsValid() && count + freeCount == slotCount;
+		slotSeen.assign(slotCount, 0);
+		for (unsigned int i = 0; i < count && valid; i++)
+		{
+			valid = slotOf[i] < slotCount && indexOfSlot[slotOf[i]] == i && !slotSeen[slotOf[i]];
+			if (valid)
+			{
+				slotSeen[slotOf[i]] = 1;
+			}
+		}
+		for (unsigned int i = 0; i < freeCount && valid; i++)
+		{
+			valid = freeSlots[i] < slotCount && !slotSeen[freeSlots[i]];
+			if (valid)
+			{
+				slotSeen[freeSlots[i]] = 1;
+			}
+		}
+		if (!valid)
+		{
+			// Back to an empty store that's safe to use, with every old handle invalidated
+			reader.Fail();
+			ResizeComponents(0);
+			freeSlots.clear();
+			for (unsigned int slot = 0; slot < slotCount; slot++)
+			{
+				generations[slot]++;
+				freeSlots.push_back(slot);
+			}
+		}
+	}
+
+private:
+	void ResizeComponents(unsigned int count)
+	{
+		x.resize(count);
+		y.resize(count);
+		rotation.resize(count);
+		previousX.resize(count);
+		previousY.resize(count);
+		previousRotation.resize(count);
+		speedX.resize(count);
+		speedY.resize(count);
+		rotationSpeed.resize(count);
+		radius.resize(count);
+		age.resize(count);
+		payload.resize(count);
+		slotOf.resize(count);
+	}
+
+	// Dense index -> slot, and slot -> dense index
+	std::vector<unsigned int> slotOf;
+	std::vector<unsigned int> indexOfSlot;
+	std::vector<unsigned int> generations;
+	std::vector<unsigned int> freeSlots;
+	// Scratch for LoadState, kept so loading doesn't allocate again
+	std::vector<char> slotSeen;
+};
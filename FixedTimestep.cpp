@@ -0,0 +1,47 @@
+#include "FixedTimestep.h"
+
+FixedTimestep::FixedTimestep(double ticksPerSecond, int maxStepsPerFrame) : accumulator(0)
+{
+    SetTickRate(ticksPerSecond);
+    SetMaxStepsPerFrame(maxStepsPerFrame);
+}
+
+FixedTimestep::~FixedTimestep()
+{
+}
+
+int FixedTimestep::Advance(double elapsedTime)
+{
+    accumulator += elapsedTime;
+
+    int steps = (int)(accumulator / tickTime);
+    if (steps > maxSteps)
+    {
+        // We fell too far behind (a hitch, a breakpoint, a dragged window): drop the time we can't catch up with
+        steps = maxSteps;
+        accumulator = steps * tickTime;
+    }
+    accumulator -= steps * tickTime;
+
+    return steps;
+}
+
+double FixedTimestep::GetTickTime()
+{
+    return tickTime;
+}
+
+double FixedTimestep::GetAlpha()
+{
+    return accumulator / tickTime;
+}
+
+void FixedTimestep::SetTickRate(double ticksPerSecond)
+{
+    tickTime = 1.0 / ticksPerSecond;
+}
+
+void FixedTimestep::SetMaxStepsPerFrame(int maxStepsPerFrame)
+{
+    maxSteps = maxStepsPerFrame < 1 ? 1 : maxStepsPerFrame;
+}
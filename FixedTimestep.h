@@ -0,0 +1,27 @@
+#pragma once
+
+// Turns variable frame times into a whole number of fixed-length simulation ticks.
+// Leftover time is carried to the next frame; what's left after the last tick is the interpolation factor for drawing
+class FixedTimestep
+{
+public:
+	// maxStepsPerFrame caps the catch-up after a hitch: time beyond it is dropped instead of simulated
+	FixedTimestep(double ticksPerSecond, int maxStepsPerFrame);
+	~FixedTimestep();
+
+	// Adds the frame's elapsed time and returns how many ticks to run now
+	int Advance(double elapsedTime);
+
+	// Length of one tick, in seconds
+	double GetTickTime();
+	// How far we are between the last tick and the next one, from 0 to 1
+	double GetAlpha();
+
+	void SetTickRate(double ticksPerSecond);
+	void SetMaxStepsPerFrame(int maxStepsPerFrame);
+
+private:
+	double tickTime;
+	int maxSteps;
+	double accumulator;
+};
@@ -0,0 +1,110 @@
+#include "FramePacer.h"
+
+// Always spin for at least this long, a sleep can't be trusted to the microsecond
+#define MIN_SPIN_MARGIN 200000
+// Not worth going to sleep for less than this
+#define MIN_SLEEP 100000
+
+FramePacer::FramePacer(Clock* clock, double framesPerSecond) :
+    clock(clock), frameRate(framesPerSecond), unfocusedFrameRate(30), idleFrameRate(10),
+    focused(true), idle(false), lastLateness(0), oversleep(1000000), oversleepDeviation(0)
+{
+    deadline = clock->Now();
+}
+
+FramePacer::~FramePacer()
+{
+}
+
+void FramePacer::SetFrameRate(double framesPerSecond)
+{
+    frameRate = framesPerSecond;
+}
+
+void FramePacer::SetUnfocusedFrameRate(double framesPerSecond)
+{
+    unfocusedFrameRate = framesPerSecond;
+}
+
+void FramePacer::SetIdleFrameRate(double framesPerSecond)
+{
+    idleFrameRate = framesPerSecond;
+}
+
+void FramePacer::SetFocused(bool newFocused)
+{
+    focused = newFocused;
+}
+
+void FramePacer::SetIdle(bool newIdle)
+{
+    idle = newIdle;
+}
+
+long long FramePacer::GetFramePeriod()
+{
+    // The lowest of the rates that apply wins
+    double rate = frameRate;
+    if (!focused && unfocusedFrameRate < rate)
+        rate = unfocusedFrameRate;
+    if (idle && idleFrameRate < rate)
+        rate = idleFrameRate;
+    return rate > 0 ? (long long)(1000000000.0 / rate) : 0;
+}
+
+void FramePacer::WaitForNextFrame()
+{
+    long long period = GetFramePeriod();
+    long long now = clock->Now();
+
+    // Deadlines follow each other exactly, so small delays don't add up.
+    // After a long hitch (or a change of rate) we start over from now instead of rushing frames to catch up
+    deadline += period;
+    if (deadline < now - period || deadline > now + period)
+    {
+        deadline = now + period;
+    }
+
+    // Sleep for most of the wait
+    long long margin = GetSpinMargin();
+    if (margin > period / 2)
+    {
+        // A few very late wake-ups must not turn the pacer into a busy loop
+        margin = period / 2;
+    }
+    long long sleepTime = deadline - margin - now;
+    if (sleepTime > MIN_SLEEP)
+    {
+        clock->Sleep(sleepTime);
+        long long overshoot = clock->Now() - (now + sleepTime);
+        if (overshoot < 0)
+            overshoot = 0;
+
+        // Smoothed average and deviation of the overshoot, the way TCP estimates round trip times
+        long long error = overshoot - oversleep;
+        oversleep += error / 8;
+        oversleepDeviation += ((error < 0 ? -error : error) - oversleepDeviation) / 4;
+    }
+
+    // And spin for the rest
+    while ((now = clock->Now()) < deadline)
+    {
+        clock->Spin();
+    }
+    lastLateness = now - deadline;
+}
+
+double FramePacer::GetFrameTime()
+{
+    return GetFramePeriod() / 1000000000.0;
+}
+
+long long FramePacer::GetLastLateness()
+{
+    return lastLateness;
+}
+
+long long FramePacer::GetSpinMargin()
+{
+    return oversleep + 2 * oversleepDeviation + MIN_SPIN_MARGIN;
+}
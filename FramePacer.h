@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Clock.h"
+
+// Holds the main loop to a target frame rate without burning a core.
+// It sleeps until shortly before each frame's deadline, then spins for the rest, so frames start within a fraction of a millisecond.
+// How early it wakes up adapts to how much, and how unevenly, the clock has been oversleeping.
+// Unfocused and idle windows (minimized, game over) drop to lower rates
+class FramePacer
+{
+public:
+	FramePacer(Clock* clock, double framesPerSecond);
+	~FramePacer();
+
+	void SetFrameRate(double framesPerSecond);
+	void SetUnfocusedFrameRate(double framesPerSecond);
+	void SetIdleFrameRate(double framesPerSecond);
+
+	void SetFocused(bool focused);
+	void SetIdle(bool idle);
+
+	// Waits until the next frame should start
+	void WaitForNextFrame();
+
+	// Length of the current frame, from the rate the pacer is running at
+	double GetFrameTime();
+	// How late the last frame started, in nanoseconds
+	long long GetLastLateness();
+	// How long the pacer currently wakes up before a deadline to spin
+	long long GetSpinMargin();
+
+private:
+	long long GetFramePeriod();
+
+	Clock* clock;
+	double frameRate;
+	double unfocusedFrameRate;
+	double idleFrameRate;
+	bool focused;
+	bool idle;
+
+	long long deadline;
+	long long lastLateness;
+	// Running estimate of how much a sleep overshoots, and how much that varies
+	long long oversleep;
+	long long oversleepDeviation;
+};
@@ -0,0 +1,70 @@
+#include "GameEvent.h"
+
+GameEventLog::GameEventLog() : end(0)
+{
+	events.resize(GAME_EVENT_CAPACITY);
+}
+
+GameEventLog::~GameEventLog()
+{
+}
+
+void GameEventLog::Publish(GameEventType type, long long tick, Point2D position, int data)
+{
+	GameEvent& event = events[end % GAME_EVENT_CAPACITY];
+	event.type = type;
+	event.tick = tick;
+	event.position = position;
+	event.data = data;
+	end++;
+}
+
+long long GameEventLog::GetBegin()
+{
+	return end > GAME_EVENT_CAPACITY ? end - GAME_EVENT_CAPACITY : 0;
+}
+
+long long GameEventLog::GetEnd()
+{
+	return end;
+}
+
+const GameEvent& GameEventLog::Get(long long number)
+{
+	return events[number % GAME_EVENT_CAPACITY];
+}
+
+GameEventReader::GameEventReader() : log(NULL), next(0), dropped(0)
+{
+}
+
+void GameEventReader::Attach(GameEventLog* newLog)
+{
+	log = newLog;
+	next = log != NULL ? log->GetEnd() : 0;
+}
+
+const GameEvent* GameEventReader::Next()
+{
+	if (log == NULL || next == log->GetEnd())
+	{
+		return NULL;
+	}
+
+	// The events we didn't get to in time were overwritten
+	long long begin = log->GetBegin();
+	if (next < begin)
+	{
+		dropped += begin - next;
+		next = begin;
+	}
+
+	const GameEvent* event = &log->Get(next);
+	next++;
+	return event;
+}
+
+long long GameEventReader::GetDropped()
+{
+	return dropped;
+}
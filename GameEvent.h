@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+#include "Point2D.h"
+
+// Enough for every event of dozens of busy ticks, so a reader can fall a few frames behind
+#define GAME_EVENT_CAPACITY 1024
+
+// Things that happen in a game, in the order Logic finds them
+enum GameEventType
+{
+	// A game started. Whatever a reader kept about the previous one is over
+	GAME_EVENT_NEW_GAME,
+	// The ship fired, from where it is
+	GAME_EVENT_PROJECTILE_FIRED,
+	// An asteroid was hit and split in 2. size is the size it had
+	GAME_EVENT_ASTEROID_SPLIT,
+	// One of the smallest asteroids was hit and burst into debris
+	GAME_EVENT_ASTEROID_DESTROYED,
+	// The ship hit an asteroid
+	GAME_EVENT_SHIP_DESTROYED,
+	// The ship came back for its next life. lives is how many are left after this one
+	GAME_EVENT_LIFE_LOST,
+	// The game ended. This is its last event, whatever goes on until the next GAME_EVENT_NEW_GAME isn't published
+	GAME_EVENT_GAME_WON,
+	// The ship was out of lives, it doesn't come back. Also the last event of its game
+	GAME_EVENT_GAME_LOST
+};
+
+struct GameEvent
+{
+	GameEventType type;
+	// Tick of the game it happened in
+	long long tick;
+	Point2D position;
+	// Asteroid size for asteroid events, lives left for GAME_EVENT_LIFE_LOST, 0 otherwise
+	int data;
+};
+
+// Everything that happened in the last ticks, as a fixed-capacity ring buffer the engine writes to.
+// Events are numbered from the first one ever published, and that number never goes back, even across games or loaded states,
+// so readers just remember the number of the next event they want. The oldest events are overwritten when the buffer is full.
+// The buffer is allocated once; publishing and reading never allocate
+class GameEventLog
+{
+public:
+	GameEventLog();
+	~GameEventLog();
+
+	void Publish(GameEventType type, long long tick, Point2D position, int data);
+
+	// Number of the oldest event still in the buffer, and one past the newest
+	long long GetBegin();
+	long long GetEnd();
+	// The event with that number, which must be between GetBegin and GetEnd
+	const GameEvent& Get(long long number);
+
+private:
+	std::vector<GameEvent> events;
+	long long end;
+};
+
+// Reads a GameEventLog at its own pace, like scoring, sound or a replay index would. Any number of them can read the same log.
+// They're plain objects, on the thread that runs Logic: reading one event is an index and a copy
+class GameEventReader
+{
+public:
+	GameEventReader();
+
+	// From now on, Next returns the events published after this call
+	void Attach(GameEventLog* newLog);
+	// The next event, or NULL when there's nothing new. A reader that fell more than GAME_EVENT_CAPACITY events behind
+	// skips to the oldest one still there, and the ones it missed are counted in GetDropped
+	const GameEvent* Next();
+	long long GetDropped();
+
+private:
+	GameEventLog* log;
+	long long next;
+	long long dropped;
+};
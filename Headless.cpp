@@ -0,0 +1,502 @@
+// Headless.cpp : Runs games without a window or a renderer, as fast as the CPU allows.
+// Used for balancing and bot evaluation, where thousands of games are simulated back to back
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <chrono>
+#include <vector>
+#include "Engine.h"
+#include "BatchRunner.h"
+#include "FramePacer.h"
+#include "SceneBuilder.h"
+#include "RenderBackend.h"
+#include "VideoExporter.h"
+
+// Simple scripted pilot: keeps turning, fires in bursts and thrusts every few seconds
+static void DriveBot(Engine* engine, long long tick)
+{
+    if (tick == 0)
+    {
+        engine->KeyDown(VK_RIGHT);
+    }
+    if (tick % 10 == 0)
+    {
+        engine->KeyDown(VK_SPACE);
+    }
+    if (tick % 10 == 5)
+    {
+        engine->KeyUp(VK_SPACE);
+    }
+    if (tick % 300 == 0)
+    {
+        engine->KeyDown(VK_UP);
+    }
+    if (tick % 300 == 60)
+    {
+        engine->KeyUp(VK_UP);
+    }
+}
+
+// Builds the command list the game would draw right now, and writes it out as text
+static bool DumpFrame(Engine* engine, const char* path)
+{
+    RenderSnapshot snapshot;
+    engine->WriteSnapshot(&snapshot);
+    SceneBuilder scene;
+    CommandList commands;
+    scene.Build(&snapshot, 1, &commands);
+    RecordingBackend backend;
+    backend.Submit(&commands);
+
+    FILE* file = fopen(path, "w");
+    if (file == NULL)
+    {
+        return false;
+    }
+    backend.WriteText(file);
+    return fclose(file) == 0;
+}
+
+// Plays the games one after the other on this thread. Each game ends when it's over or after maxTicks
+// With a recording path, every key the bot presses is recorded so the session can be replayed later.
+// With a dump path, the frame of the first game at dumpTick is written out as a command list
+static int RunSequential(int games, long long maxTicks, double tickTime, unsigned long long seed, const char* recordPath,
+    long long dumpTick, const char* dumpPath)
+{
+    long long totalTicks = 0;
+    int won = 0;
+    int lost = 0;
+    // Counted from the engine's events, one count per GameEventType
+    long long eventCounts[GAME_EVENT_GAME_LOST + 1] = {};
+
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+    // Game number i plays with seed + i, so any game can be replayed on its own
+    EngineConfig config;
+    config.tickTime = tickTime;
+    Engine engine(config);
+    InputRecording recording;
+    if (recordPath != NULL)
+    {
+        recording.Start(tickTime);
+        engine.SetInputRecording(&recording);
+    }
+    GameEventReader events;
+    events.Attach(engine.GetEvents());
+
+    for (int game = 0; game < games; game++)
+    {
+        engine.NewGame(seed + game);
+        long long tick = 0;
+        while (tick < maxTicks && !engine.IsGameOver())
+        {
+            DriveBot(&engine, tick);
+            engine.Logic(tickTime);
+            tick++;
+            for (const GameEvent* event = events.Next(); event != NULL; event = events.Next())
+            {
+                eventCounts[event->type]++;
+            }
+
+            if (dumpPath != NULL && game == 0 && tick == dumpTick && !DumpFrame(&engine, dumpPath))
+            {
+                fprintf(stderr, "Can't write %s\n", dumpPath);
+                return 1;
+            }
+        }
+        totalTicks += tick;
+
+        if (engine.IsGameOver())
+        {
+            if (engine.IsGameWon())
+                won++;
+            else
+                lost++;
+        }
+    }
+
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    double elapsedSecs = std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() / 1000000.0;
+
+    if (recordPath != NULL)
+    {
+        recording.Finish(engine.GetTick());
+        if (!recording.SaveToFile(recordPath))
+        {
+            fprintf(stderr, "Can't write %s\n", recordPath);
+            return 1;
+        }
+        printf("recorded: %zu bytes to %s\n", recording.GetSize(), recordPath);
+    }
+
+    printf("games: %d (won %d, lost %d, unfinished %d)\n", games, won, lost, games - won - lost);
+    printf("ticks: %lld in %.3f s\n", totalTicks, elapsedSecs);
+    printf("events: %lld shots, %lld splits, %lld asteroids destroyed, %lld ships destroyed\n",
+        eventCounts[GAME_EVENT_PROJECTILE_FIRED], eventCounts[GAME_EVENT_ASTEROID_SPLIT],
+        eventCounts[GAME_EVENT_ASTEROID_DESTROYED], eventCounts[GAME_EVENT_SHIP_DESTROYED]);
+    if (elapsedSecs > 0)
+    {
+        printf("ticks/s: %.0f\n", totalTicks / elapsedSecs);
+    }
+
+    return 0;
+}
+
+// Plays recorded sessions again, as fast as possible. The checksum of the final state changes
+// if the game plays out any differently, which makes recordings usable as regression tests
+static int RunReplay(int fileCount, char** paths)
+{
+    int result = 0;
+    std::vector<unsigned char> state;
+    for (int i = 0; i < fileCount; i++)
+    {
+        InputRecording recording;
+        if (!recording.LoadFromFile(paths[i]))
+        {
+            fprintf(stderr, "Can't read %s\n", paths[i]);
+            result = 1;
+            continue;
+        }
+
+        // A fresh engine for each file, so the checksum doesn't depend on what was replayed before
+        EngineConfig config;
+        config.tickTime = recording.GetTickTime();
+        Engine engine(config);
+
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        ReplayResult replay = recording.Replay(&engine);
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        double elapsedSecs = std::chrono::duration<double>(end - begin).count();
+
+        // FNV-1a of the whole engine state
+        state.resize(engine.GetStateSize());
+        engine.SaveState(state.data(), state.size());
+        unsigned long long checksum = 14695981039346656037ULL;
+        for (size_t b = 0; b < state.size(); b++)
+        {
+            checksum = (checksum ^ state[b]) * 1099511628211ULL;
+        }
+
+        // The checksum only matches builds with the same physics numbers
+        printf("%s: games %d (won %d, lost %d), ticks %lld in %.3f s, state %016llx (%s)\n",
+            paths[i], replay.games, replay.won, replay.lost, replay.ticks, elapsedSecs, checksum, GetScalarName());
+    }
+    return result;
+}
+
+// Draws a recorded session into a video, one frame every frameStep ticks, on all the threads.
+// A path ending in .y4m gets a YUV4MPEG2 video, anything else raw RGB frames. "-" writes to stdout, to pipe into an encoder
+static int RunExport(const char* recordingPath, const char* videoPath, int frameStep, int threads)
+{
+    InputRecording recording;
+    if (!recording.LoadFromFile(recordingPath))
+    {
+        fprintf(stderr, "Can't read %s\n", recordingPath);
+        return 1;
+    }
+
+    bool toStdout = strcmp(videoPath, "-") == 0;
+    FILE* file = toStdout ? stdout : fopen(videoPath, "wb");
+    if (file == NULL)
+    {
+        fprintf(stderr, "Can't write %s\n", videoPath);
+        return 1;
+    }
+
+    size_t pathLength = strlen(videoPath);
+    VideoFormat format = pathLength >= 4 && strcmp(videoPath + pathLength - 4, ".y4m") == 0 ? VIDEO_Y4M : VIDEO_RAW_RGB;
+    VideoExporter exporter(file, format, threads, frameStep);
+
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    EngineConfig config;
+    config.tickTime = recording.GetTickTime();
+    Engine engine(config);
+    bool written = exporter.Start(recording.GetTickTime());
+    ReplayResult replay = recording.Replay(&engine, &exporter);
+    written = exporter.Finish() && written;
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    double elapsedSecs = std::chrono::duration<double>(end - begin).count();
+
+    if (!toStdout)
+    {
+        written = fclose(file) == 0 && written;
+    }
+    if (!written)
+    {
+        fprintf(stderr, "Can't write %s\n", videoPath);
+        return 1;
+    }
+
+    // Real time is how long the session took to play
+    double sessionSecs = replay.ticks * recording.GetTickTime();
+    fprintf(stderr, "%s: %lld frames in %.3f s, %.1f times real time\n", videoPath, exporter.GetFrameCount(), elapsedSecs,
+        elapsedSecs > 0 ? sessionSecs / elapsedSecs : 0);
+    return 0;
+}
+
+// Plays the games like RunSequential, but every second forks the game into a second engine through a saved state
+// and plays the next second on both. Both must end up byte for byte in the same state
+static int RunStateCheck(int games, long long maxTicks, double tickTime, unsigned long long seed)
+{
+    const long long forkInterval = 60;
+    long long forks = 0;
+    long long mismatches = 0;
+    double saveSecs = 0;
+    double loadSecs = 0;
+
+    EngineConfig config;
+    config.tickTime = tickTime;
+    Engine engine(config);
+    Engine fork(config);
+    std::vector<unsigned char> forkState;
+    std::vector<unsigned char> engineState;
+    std::vector<unsigned char> checkState;
+    for (int game = 0; game < games; game++)
+    {
+        engine.NewGame(seed + game);
+        long long tick = 0;
+        while (tick < maxTicks && !engine.IsGameOver())
+        {
+            if (tick % forkInterval == 0)
+            {
+                std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+                forkState.resize(engine.GetStateSize());
+                engine.SaveState(forkState.data(), forkState.size());
+                std::chrono::steady_clock::time_point saved = std::chrono::steady_clock::now();
+                fork.LoadState(forkState.data(), forkState.size());
+                std::chrono::steady_clock::time_point loaded = std::chrono::steady_clock::now();
+                saveSecs += std::chrono::duration<double>(saved - begin).count();
+                loadSecs += std::chrono::duration<double>(loaded - saved).count();
+
+                for (long long t = tick; t < tick + forkInterval; t++)
+                {
+                    DriveBot(&fork, t);
+                    fork.Logic(tickTime);
+                }
+                forks++;
+            }
+
+            DriveBot(&engine, tick);
+            engine.Logic(tickTime);
+            tick++;
+
+            if (tick % forkInterval == 0)
+            {
+                engineState.resize(engine.GetStateSize());
+                engine.SaveState(engineState.data(), engineState.size());
+                checkState.resize(fork.GetStateSize());
+                fork.SaveState(checkState.data(), checkState.size());
+                if (engineState != checkState)
+                {
+                    mismatches++;
+                }
+            }
+        }
+    }
+
+    printf("forks: %lld, mismatches: %lld\n", forks, mismatches);
+    if (forks > 0)
+    {
+        printf("save: %.2f us, load: %.2f us\n", saveSecs * 1000000 / forks, loadSecs * 1000000 / forks);
+    }
+
+    return mismatches == 0 ? 0 : 2;
+}
+
+// Seconds of frames --pace measures without --ticks
+#define PACE_DEFAULT_SECONDS 5
+
+// Runs a game paced like the real main loop, and reports how evenly the frames start and how much CPU the waiting used.
+// With the virtual clock nothing really waits: sleeps oversleep by a fixed 1.5 ms, to check the pacer makes up for it
+static int RunPacing(double framesPerSecond, int frames, bool virtualClock, double tickTime, unsigned long long seed)
+{
+    SystemClock systemClock;
+    ManualClock manualClock(1500000, 1000);
+    Clock* pacerClock = virtualClock ? (Clock*)&manualClock : (Clock*)&systemClock;
+    FramePacer pacer(pacerClock, framesPerSecond);
+
+    EngineConfig config;
+    config.tickTime = tickTime;
+    Engine engine(config);
+    engine.NewGame(seed);
+
+    long long period = (long long)(1000000000.0 / framesPerSecond);
+    long long maxJitter = 0;
+    double totalJitter = 0;
+    int steadyFrames = 0;
+    int onTimeFrames = 0;
+    long long previousStart = 0;
+    clock_t cpuBegin = clock();
+    long long wallBegin = pacerClock->Now();
+
+    for (int frame = 0; frame <= frames; frame++)
+    {
+        long long start = pacerClock->Now();
+        if (frame > 0)
+        {
+            long long jitter = start - previousStart - period;
+            if (jitter < 0)
+                jitter = -jitter;
+            if (jitter > maxJitter)
+                maxJitter = jitter;
+            totalJitter += jitter;
+            if (jitter <= 500000)
+                steadyFrames++;
+        }
+        previousStart = start;
+
+        // Some work, like a frame of the game would do
+        DriveBot(&engine, frame);
+        engine.Logic(tickTime);
+        if (virtualClock)
+        {
+            manualClock.Advance(2000000);
+        }
+
+        pacer.WaitForNextFrame();
+        if (frame > 0 && pacer.GetLastLateness() <= 500000)
+            onTimeFrames++;
+    }
+
+    double wallSecs = (pacerClock->Now() - wallBegin) / 1000000000.0;
+    double cpuSecs = (double)(clock() - cpuBegin) / CLOCKS_PER_SEC;
+
+    printf("frames: %d at %.1f fps (%s clock)\n", frames, framesPerSecond, virtualClock ? "virtual" : "system");
+    printf("frame start jitter: average %.3f ms, max %.3f ms, %.1f%% within 0.5 ms\n",
+        totalJitter / frames / 1000000.0, maxJitter / 1000000.0, steadyFrames * 100.0 / frames);
+    printf("frames starting within 0.5 ms of their deadline: %.1f%%\n", onTimeFrames * 100.0 / frames);
+    printf("spin margin: %.3f ms\n", pacer.GetSpinMargin() / 1000000.0);
+    if (!virtualClock && wallSecs > 0)
+    {
+        printf("cpu: %.1f%% of one core\n", cpuSecs * 100 / wallSecs);
+    }
+
+    return 0;
+}
+
+// Runs many engines at once on all the cores, each one for the given number of ticks
+static int RunBatch(int engines, int threads, bool lockstep, long long ticks, double tickTime, unsigned long long seed)
+{
+    EngineConfig config;
+    config.seed = seed;
+    config.tickTime = tickTime;
+
+    BatchRunner runner(engines, threads, config);
+    runner.SetInputPolicy(DriveBot);
+
+    BatchResult result = lockstep ? runner.RunLockstep(ticks, tickTime) : runner.RunFree(ticks, tickTime);
+
+    printf("engines: %d on %d threads (%s)\n", engines, runner.GetThreadCount(), lockstep ? "lockstep" : "free");
+    printf("games finished: %d (won %d, lost %d)\n", result.gamesWon + result.gamesLost, result.gamesWon, result.gamesLost);
+    printf("ticks: %lld in %.3f s\n", result.ticks, result.seconds);
+    if (result.seconds > 0)
+    {
+        printf("ticks/s: %.0f\n", result.ticks / result.seconds);
+    }
+
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    int games = 100;
+    long long maxTicks = 60 * 60 * 5;
+    bool ticksGiven = false;
+    double tickTime = 1.0 / 60;
+    unsigned long long seed = 1;
+    int engines = 0;
+    int threads = 0;
+    bool lockstep = false;
+    bool checkState = false;
+    const char* recordPath = NULL;
+    const char* tracePath = NULL;
+    long long dumpTick = 0;
+    const char* dumpPath = NULL;
+    int frameStep = 1;
+    double paceFrameRate = 0;
+    bool virtualClock = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--games") == 0 && i + 1 < argc)
+            games = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc)
+        {
+            maxTicks = atoll(argv[++i]);
+            ticksGiven = true;
+        }
+        else if (strcmp(argv[i], "--dt") == 0 && i + 1 < argc)
+            tickTime = atof(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            seed = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--engines") == 0 && i + 1 < argc)
+            engines = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--lockstep") == 0)
+            lockstep = true;
+        else if (strcmp(argv[i], "--check-state") == 0)
+            checkState = true;
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+            recordPath = argv[++i];
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+            tracePath = argv[++i];
+        else if (strcmp(argv[i], "--dump-frame") == 0 && i + 2 < argc)
+        {
+            dumpTick = atoll(argv[++i]);
+            dumpPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--pace") == 0 && i + 1 < argc)
+            paceFrameRate = atof(argv[++i]);
+        else if (strcmp(argv[i], "--virtual-clock") == 0)
+            virtualClock = true;
+        else if (strcmp(argv[i], "--frame-step") == 0 && i + 1 < argc)
+            frameStep = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--export") == 0 && i + 2 < argc)
+            return RunExport(argv[i + 1], argv[i + 2], frameStep, threads);
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+            return RunReplay(argc - i - 1, argv + i + 1);
+        else
+        {
+            fprintf(stderr, "Usage: %s [--games N] [--ticks N] [--dt seconds] [--seed N] [--check-state] [--record file] [--trace file]\n", argv[0]);
+            fprintf(stderr, "       %s [--games N] [--seed N] --dump-frame tick file\n", argv[0]);
+            fprintf(stderr, "       %s --replay file...\n", argv[0]);
+            fprintf(stderr, "       %s [--threads N] [--frame-step ticks] --export recording video.y4m|frames.rgb|-\n", argv[0]);
+            fprintf(stderr, "       %s --pace fps [--ticks frames] [--virtual-clock]\n", argv[0]);
+            fprintf(stderr, "       %s --engines N [--threads N] [--lockstep] [--ticks N] [--dt seconds] [--seed N] [--trace file]\n", argv[0]);
+            fprintf(stderr, "With --engines, N engines run in parallel for --ticks ticks each\n");
+            fprintf(stderr, "With --check-state, every game is forked through a saved state each second and both copies compared\n");
+            fprintf(stderr, "With --export, a recording is drawn on the CPU into Y4M video or raw 800x600 RGB frames\n");
+            fprintf(stderr, "With --pace, %d seconds of frames are measured unless --ticks gives the number of frames\n", PACE_DEFAULT_SECONDS);
+            fprintf(stderr, "With --dump-frame, the draw commands of the first game at that tick are written as text\n");
+            fprintf(stderr, "With --trace file, the timing of the last ticks of every thread is written as a Chrome trace\n");
+            return 1;
+        }
+    }
+
+    Trace::SetEnabled(tracePath != NULL);
+
+    int result;
+    if (paceFrameRate > 0)
+    {
+        // Pacing runs in real time, so it measures a few seconds of frames unless told otherwise, not a whole game's worth of ticks
+        int frames = ticksGiven ? (int)maxTicks : (int)(paceFrameRate * PACE_DEFAULT_SECONDS);
+        result = RunPacing(paceFrameRate, frames, virtualClock, tickTime, seed);
+    }
+    else if (engines > 0)
+        result = RunBatch(engines, threads, lockstep, maxTicks, tickTime, seed);
+    else if (checkState)
+        result = RunStateCheck(games, maxTicks, tickTime, seed);
+    else
+        result = RunSequential(games, maxTicks, tickTime, seed, recordPath, dumpTick, dumpPath);
+
+    if (tracePath != NULL && !Trace::ExportChromeJson(tracePath))
+    {
+        fprintf(stderr, "Can't write %s\n", tracePath);
+        return 1;
+    }
+    return result;
+}
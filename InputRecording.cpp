@@ -0,0 +1,255 @@
+#include <stdio.h>
+#include <string.h>
+#include "Engine.h"
+#include "InputRecording.h"
+
+#define RECORDING_MAGIC "AREC"
+#define RECORDING_VERSION 2
+// Version 1 recordings have no key events partway through a tick, they still play
+#define RECORDING_OLDEST_VERSION 1
+
+#define EVENT_NEW_GAME 8
+#define EVENT_END 9
+#define EVENT_KEY_WITH_OFFSET 10
+
+// The keys the engine reacts to. Their position in this list is what goes in the file
+static const unsigned int RECORDED_KEYS[] = { VK_LEFT, VK_RIGHT, VK_UP, VK_SPACE };
+static const int RECORDED_KEY_COUNT = 4;
+
+InputRecording::InputRecording() : tickTime(0), lastTick(0), finished(false)
+{
+}
+
+void InputRecording::Start(double newTickTime)
+{
+	tickTime = newTickTime;
+	lastTick = 0;
+	finished = false;
+	events.clear();
+}
+
+void InputRecording::WriteVarint(uint64_t value)
+{
+	// 7 bits at a time, the high bit says more bytes follow
+	while (value >= 0x80)
+	{
+		events.push_back((unsigned char)(value | 0x80));
+		value >>= 7;
+	}
+	events.push_back((unsigned char)value);
+}
+
+bool InputRecording::ReadVarint(size_t& position, uint64_t& value)
+{
+	value = 0;
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		if (position >= events.size())
+		{
+			return false;
+		}
+		unsigned char byte = events[position++];
+		value |= (uint64_t)(byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void InputRecording::WriteEvent(long long tick, unsigned int type)
+{
+	// Ticks always go forward within a game, and a new game restarts them from 0
+	long long delta = tick >= lastTick ? tick - lastTick : 0;
+	WriteVarint(((uint64_t)delta << 4) | type);
+	lastTick = tick;
+}
+
+void InputRecording::RecordNewGame(long long tick, uint64_t seed)
+{
+	if (finished)
+	{
+		return;
+	}
+	WriteEvent(tick, EVENT_NEW_GAME);
+	WriteVarint(seed);
+	lastTick = 0;
+}
+
+void InputRecording::RecordKey(long long tick, unsigned int key, bool pressed, int offsetSteps)
+{
+	if (finished)
+	{
+		return;
+	}
+	for (int i = 0; i < RECORDED_KEY_COUNT; i++)
+	{
+		if (RECORDED_KEYS[i] == key)
+		{
+			unsigned int keyBits = i * 2 + (pressed ? 1 : 0);
+			if (offsetSteps == 0)
+			{
+				WriteEvent(tick, keyBits);
+			}
+			else
+			{
+				WriteEvent(tick, EVENT_KEY_WITH_OFFSET);
+				WriteVarint(((uint64_t)offsetSteps << 3) | keyBits);
+			}
+			return;
+		}
+	}
+	// Any other key doesn't change the game, so it isn't worth a byte
+}
+
+void InputRecording::Finish(long long tick)
+{
+	if (finished)
+	{
+		return;
+	}
+	WriteEvent(tick, EVENT_END);
+	finished = true;
+}
+
+bool InputRecording::SaveToFile(const char* path)
+{
+	FILE* file = fopen(path, "wb");
+	if (file == NULL)
+	{
+		return false;
+	}
+
+	unsigned char version = RECORDING_VERSION;
+	bool ok = fwrite(RECORDING_MAGIC, 1, 4, file) == 4
+		&& fwrite(&version, 1, 1, file) == 1
+		&& fwrite(&tickTime, sizeof(tickTime), 1, file) == 1
+		&& (events.empty() || fwrite(events.data(), 1, events.size(), file) == events.size());
+	return fclose(file) == 0 && ok;
+}
+
+bool InputRecording::LoadFromFile(const char* path)
+{
+	FILE* file = fopen(path, "rb");
+	if (file == NULL)
+	{
+		return false;
+	}
+
+	char magic[4];
+	unsigned char version = 0;
+	double newTickTime = 0;
+	bool ok = fread(magic, 1, 4, file) == 4
+		&& memcmp(magic, RECORDING_MAGIC, 4) == 0
+		&& fread(&version, 1, 1, file) == 1
+		&& version >= RECORDING_OLDEST_VERSION
+		&& version <= RECORDING_VERSION
+		&& fread(&newTickTime, sizeof(newTickTime), 1, file) == 1
+		&& newTickTime > 0;
+
+	if (ok)
+	{
+		Start(newTickTime);
+		unsigned char buffer[4096];
+		size_t read;
+		while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		{
+			events.insert(events.end(), buffer, buffer + read);
+		}
+		finished = true;
+	}
+	fclose(file);
+	return ok;
+}
+
+ReplayResult InputRecording::Replay(Engine* engine, ReplayListener* listener)
+{
+	ReplayResult result;
+	result.ticks = 0;
+	result.games = 0;
+	result.won = 0;
+	result.lost = 0;
+
+	size_t position = 0;
+	uint64_t value;
+	while (ReadVarint(position, value))
+	{
+		// Run the ticks that passed before this event
+		long long delta = (long long)(value >> 4);
+		unsigned int type = (unsigned int)(value & 0xF);
+		for (long long t = 0; t < delta; t++)
+		{
+			engine->Logic(tickTime);
+			if (listener != NULL)
+			{
+				listener->OnTick(engine);
+			}
+		}
+		result.ticks += delta;
+
+		if (type < EVENT_NEW_GAME || type == EVENT_KEY_WITH_OFFSET)
+		{
+			unsigned int keyBits = type;
+			uint64_t offsetSteps = 0;
+			if (type == EVENT_KEY_WITH_OFFSET)
+			{
+				uint64_t offsetValue;
+				if (!ReadVarint(position, offsetValue))
+				{
+					break;
+				}
+				keyBits = (unsigned int)(offsetValue & 7);
+				offsetSteps = offsetValue >> 3;
+			}
+
+			if (keyBits / 2 >= (unsigned int)RECORDED_KEY_COUNT)
+			{
+				break;
+			}
+			unsigned int key = RECORDED_KEYS[keyBits / 2];
+			double offset = (double)offsetSteps / INPUT_OFFSET_STEPS;
+			if (keyBits & 1)
+				engine->KeyDown(key, offset);
+			else
+				engine->KeyUp(key, offset);
+			continue;
+		}
+
+		// The game that was being played ends here
+		if (result.games > 0 && engine->IsGameOver())
+		{
+			if (engine->IsGameWon())
+				result.won++;
+			else
+				result.lost++;
+		}
+
+		if (type == EVENT_NEW_GAME)
+		{
+			uint64_t seed;
+			if (!ReadVarint(position, seed))
+			{
+				break;
+			}
+			engine->NewGame(seed);
+			result.games++;
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	return result;
+}
+
+double InputRecording::GetTickTime()
+{
+	return tickTime;
+}
+
+size_t InputRecording::GetSize()
+{
+	return events.size();
+}
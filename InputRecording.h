@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+class Engine;
+
+// Key changes partway through a tick are kept in 1/256ths of a tick
+#define INPUT_OFFSET_STEPS 256
+
+// Outcome of replaying a recording
+struct ReplayResult
+{
+	long long ticks;
+	int games;
+	int won;
+	int lost;
+};
+
+// Gets to look at the engine after every tick of a replay, to draw or check it
+class ReplayListener
+{
+public:
+	virtual ~ReplayListener()
+	{
+	}
+
+	virtual void OnTick(Engine* engine) = 0;
+};
+
+// The keys an Engine receives, with the tick they arrived on and the seed of every game.
+// That is all it takes to play a session again exactly, at a tiny fraction of the size of any frame capture.
+//
+// The file is a short header (magic, version, tick time) followed by one varint per event:
+// the ticks since the previous event, shifted left by 4, with the event type in the low 4 bits.
+// Key events at the start of a tick are 0-7 (key index * 2 + pressed). Key events partway through a tick (10) are followed by
+// a varint of the offset shifted left by 3 with the same key bits. A new game (8) is followed by a varint seed, and the end (9) closes the recording
+class InputRecording
+{
+public:
+	InputRecording();
+
+	// Forgets everything recorded so far
+	void Start(double tickTime);
+	// Called by the engine it's attached to (see Engine::SetInputRecording)
+	void RecordNewGame(long long tick, uint64_t seed);
+	// offsetSteps is how far into the tick the key changed, in 1/INPUT_OFFSET_STEPS of a tick
+	void RecordKey(long long tick, unsigned int key, bool pressed, int offsetSteps);
+	// Stores how long the last game went on after its last key
+	void Finish(long long tick);
+
+	bool SaveToFile(const char* path);
+	bool LoadFromFile(const char* path);
+
+	// Plays the whole recording on the engine as fast as possible.
+	// The engine must use the same configuration as the one that was recorded.
+	// The listener, if any, is called after every tick
+	ReplayResult Replay(Engine* engine, ReplayListener* listener = NULL);
+
+	double GetTickTime();
+	size_t GetSize();
+
+private:
+	void WriteEvent(long long tick, unsigned int type);
+	void WriteVarint(uint64_t value);
+	bool ReadVarint(size_t& position, uint64_t& value);
+
+	double tickTime;
+	long long lastTick;
+	bool finished;
+	std::vector<unsigned char> events;
+};
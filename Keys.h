@@ -0,0 +1,11 @@
+#pragma once
+
+// Key codes understood by Engine::KeyDown/KeyUp.
+// On Windows these come from <windows.h>; everywhere else we define the same values,
+// so input recorded on one platform means the same thing on the other
+#ifndef VK_LEFT
+#define VK_SPACE 0x20
+#define VK_LEFT 0x25
+#define VK_UP 0x26
+#define VK_RIGHT 0x27
+#endif
@@ -0,0 +1,194 @@
+#include "World.h"
+#include "Motion.h"
+
+#if !defined(ASTEROIDS_DISABLE_SIMD) && !defined(ASTEROIDS_FIXED_POINT) && (defined(__x86_64__) || defined(_M_X64))
+#define MOTION_X64
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+// MSVC lets any function use any instruction set
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+// One entity, the way every level does it. The vector loops below do exactly this, lane by lane
+static inline void IntegrateOne(const MotionArrays& a, int i, Scalar elapsedTime, bool wrap)
+{
+	a.previousX[i] = a.x[i];
+	a.previousY[i] = a.y[i];
+	a.previousRotation[i] = a.rotation[i];
+	Scalar movedX = a.x[i] + elapsedTime * a.speedX[i];
+	Scalar movedY = a.y[i] + elapsedTime * a.speedY[i];
+	a.rotation[i] = a.rotation[i] + a.rotationSpeed[i] * elapsedTime;
+	a.age[i] = a.age[i] + elapsedTime;
+
+	if (wrap)
+	{
+		Scalar wrappedX = WrapCoordinate(movedX, RESOLUTION_X);
+		Scalar wrappedY = WrapCoordinate(movedY, RESOLUTION_Y);
+		a.previousX[i] += wrappedX - movedX;
+		a.previousY[i] += wrappedY - movedY;
+		movedX = wrappedX;
+		movedY = wrappedY;
+	}
+	a.x[i] = movedX;
+	a.y[i] = movedY;
+}
+
+static void IntegrateScalar(const MotionArrays& a, int begin, int count, Scalar elapsedTime, bool wrap)
+{
+	for (int i = begin; i < count; i++)
+	{
+		IntegrateOne(a, i, elapsedTime, wrap);
+	}
+}
+
+#ifdef MOTION_X64
+
+// WrapCoordinate without branches: below the low edge becomes the high edge and the other way round
+static inline __m128d Wrap2(__m128d value, __m128d low, __m128d high)
+{
+	__m128d below = _mm_cmplt_pd(value, low);
+	__m128d above = _mm_cmpgt_pd(value, high);
+	__m128d result = _mm_or_pd(_mm_and_pd(below, high), _mm_andnot_pd(below, value));
+	return _mm_or_pd(_mm_and_pd(above, low), _mm_andnot_pd(above, result));
+}
+
+// SSE2 is always there on x64: 2 entities at a time
+static int IntegrateSse2(const MotionArrays& a, int count, double elapsedTime, bool wrap)
+{
+	__m128d dt = _mm_set1_pd(elapsedTime);
+	__m128d lowX = _mm_set1_pd(-SCREEN_MARGIN);
+	__m128d highX = _mm_set1_pd(RESOLUTION_X + SCREEN_MARGIN);
+	__m128d lowY = _mm_set1_pd(-SCREEN_MARGIN);
+	__m128d highY = _mm_set1_pd(RESOLUTION_Y + SCREEN_MARGIN);
+
+	int i = 0;
+	for (; i + 2 <= count; i += 2)
+	{
+		__m128d x = _mm_loadu_pd(a.x + i);
+		__m128d y = _mm_loadu_pd(a.y + i);
+		__m128d rotation = _mm_loadu_pd(a.rotation + i);
+		__m128d movedX = _mm_add_pd(x, _mm_mul_pd(dt, _mm_loadu_pd(a.speedX + i)));
+		__m128d movedY = _mm_add_pd(y, _mm_mul_pd(dt, _mm_loadu_pd(a.speedY + i)));
+		_mm_storeu_pd(a.previousRotation + i, rotation);
+		_mm_storeu_pd(a.rotation + i, _mm_add_pd(rotation, _mm_mul_pd(_mm_loadu_pd(a.rotationSpeed + i), dt)));
+		_mm_storeu_pd(a.age + i, _mm_add_pd(_mm_loadu_pd(a.age + i), dt));
+
+		if (wrap)
+		{
+			__m128d wrappedX = Wrap2(movedX, lowX, highX);
+			__m128d wrappedY = Wrap2(movedY, lowY, highY);
+			x = _mm_add_pd(x, _mm_sub_pd(wrappedX, movedX));
+			y = _mm_add_pd(y, _mm_sub_pd(wrappedY, movedY));
+			movedX = wrappedX;
+			movedY = wrappedY;
+		}
+		_mm_storeu_pd(a.previousX + i, x);
+		_mm_storeu_pd(a.previousY + i, y);
+		_mm_storeu_pd(a.x + i, movedX);
+		_mm_storeu_pd(a.y + i, movedY);
+	}
+	return i;
+}
+
+TARGET_AVX2 static inline __m256d Wrap4(__m256d value, __m256d low, __m256d high)
+{
+	__m256d result = _mm256_blendv_pd(value, high, _mm256_cmp_pd(value, low, _CMP_LT_OQ));
+	return _mm256_blendv_pd(result, low, _mm256_cmp_pd(value, high, _CMP_GT_OQ));
+}
+
+// 4 entities at a time
+TARGET_AVX2 static int IntegrateAvx2(const MotionArrays& a, int count, double elapsedTime, bool wrap)
+{
+	__m256d dt = _mm256_set1_pd(elapsedTime);
+	__m256d lowX = _mm256_set1_pd(-SCREEN_MARGIN);
+	__m256d highX = _mm256_set1_pd(RESOLUTION_X + SCREEN_MARGIN);
+	__m256d lowY = _mm256_set1_pd(-SCREEN_MARGIN);
+	__m256d highY = _mm256_set1_pd(RESOLUTION_Y + SCREEN_MARGIN);
+
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m256d x = _mm256_loadu_pd(a.x + i);
+		__m256d y = _mm256_loadu_pd(a.y + i);
+		__m256d rotation = _mm256_loadu_pd(a.rotation + i);
+		__m256d movedX = _mm256_add_pd(x, _mm256_mul_pd(dt, _mm256_loadu_pd(a.speedX + i)));
+		__m256d movedY = _mm256_add_pd(y, _mm256_mul_pd(dt, _mm256_loadu_pd(a.speedY + i)));
+		_mm256_storeu_pd(a.previousRotation + i, rotation);
+		_mm256_storeu_pd(a.rotation + i, _mm256_add_pd(rotation, _mm256_mul_pd(_mm256_loadu_pd(a.rotationSpeed + i), dt)));
+		_mm256_storeu_pd(a.age + i, _mm256_add_pd(_mm256_loadu_pd(a.age + i), dt));
+
+		if (wrap)
+		{
+			__m256d wrappedX = Wrap4(movedX, lowX, highX);
+			__m256d wrappedY = Wrap4(movedY, lowY, highY);
+			x = _mm256_add_pd(x, _mm256_sub_pd(wrappedX, movedX));
+			y = _mm256_add_pd(y, _mm256_sub_pd(wrappedY, movedY));
+			movedX = wrappedX;
+			movedY = wrappedY;
+		}
+		_mm256_storeu_pd(a.previousX + i, x);
+		_mm256_storeu_pd(a.previousY + i, y);
+		_mm256_storeu_pd(a.x + i, movedX);
+		_mm256_storeu_pd(a.y + i, movedY);
+	}
+	return i;
+}
+
+static bool CpuHasAvx2()
+{
+#ifdef _MSC_VER
+	// AVX2 needs the CPU to have it and the OS to save the YMM registers
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+	{
+		return false;
+	}
+	__cpuid(info, 1);
+	bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+	__cpuidex(info, 7, 0);
+	return osSavesYmm && (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+SimdLevel GetSimdLevel()
+{
+#ifdef MOTION_X64
+	static const SimdLevel level = CpuHasAvx2() ? SIMD_AVX2 : SIMD_SSE2;
+	return level;
+#else
+	return SIMD_SCALAR;
+#endif
+}
+
+const char* GetSimdLevelName(SimdLevel level)
+{
+	static const char* names[SIMD_LEVEL_COUNT] = { "scalar", "sse2", "avx2" };
+	return level >= 0 && level < SIMD_LEVEL_COUNT ? names[level] : "?";
+}
+
+void IntegrateMotion(const MotionArrays& arrays, int count, Scalar elapsedTime, bool wrap, SimdLevel level)
+{
+	if (level > GetSimdLevel())
+	{
+		level = GetSimdLevel();
+	}
+
+	// The vector loops stop at the last full vector, the scalar loop does the rest
+	int done = 0;
+#ifdef MOTION_X64
+	if (level == SIMD_AVX2)
+		done = IntegrateAvx2(arrays, count, elapsedTime, wrap);
+	else if (level == SIMD_SSE2)
+		done = IntegrateSse2(arrays, count, elapsedTime, wrap);
+#endif
+	IntegrateScalar(arrays, done, count, elapsedTime, wrap);
+}
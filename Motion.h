@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Scalar.h"
+
+// Instruction sets the motion kernel can use, from slowest to fastest
+enum SimdLevel
+{
+	SIMD_SCALAR,
+	SIMD_SSE2,
+	SIMD_AVX2,
+	SIMD_LEVEL_COUNT
+};
+
+// The components the motion kernel goes through, one array each, all count long
+struct MotionArrays
+{
+	Scalar* x;
+	Scalar* y;
+	Scalar* rotation;
+	Scalar* previousX;
+	Scalar* previousY;
+	Scalar* previousRotation;
+	const Scalar* speedX;
+	const Scalar* speedY;
+	const Scalar* rotationSpeed;
+	Scalar* age;
+};
+
+// Best level this CPU (and build) supports. Builds with ASTEROIDS_DISABLE_SIMD or ASTEROIDS_FIXED_POINT always use the scalar loop
+SimdLevel GetSimdLevel();
+const char* GetSimdLevelName(SimdLevel level);
+
+// Remembers the current transform as the previous one, moves and turns every entity by its speed and ages it.
+// With wrap, whatever leaves the screen comes back on the other side (see WrapCoordinate) and its previous position
+// jumps by the same amount, so interpolation doesn't sweep it across the screen.
+// Every level gives bit for bit the same results: they all do the same operations in the same order, only several entities at a time.
+// Levels above GetSimdLevel() fall back to it
+void IntegrateMotion(const MotionArrays& arrays, int count, Scalar elapsedTime, bool wrap, SimdLevel level = GetSimdLevel());
@@ -0,0 +1,405 @@
+#include "Narrowphase.h"
+
+#if !defined(ASTEROIDS_DISABLE_SIMD) && !defined(ASTEROIDS_FIXED_POINT) && (defined(__x86_64__) || defined(_M_X64))
+#define NARROWPHASE_X64
+#include <immintrin.h>
+#ifdef _MSC_VER
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+// Pairs are tested from packed arrays: centers of both circles and the sum of their radii, pair after pair
+struct PackedPairs
+{
+	const Scalar* firstX;
+	const Scalar* firstY;
+	const Scalar* secondX;
+	const Scalar* secondY;
+	const Scalar* radius;
+};
+
+// One pair, the way every level does it
+static inline bool Overlaps(const PackedPairs& pairs, int p, Scalar scale)
+{
+	Scalar dx = pairs.firstX[p] - pairs.secondX[p];
+	Scalar dy = pairs.firstY[p] - pairs.secondY[p];
+	Scalar distance = dx * dx + dy * dy;
+	return distance < pairs.radius[p] * pairs.radius[p] * scale;
+}
+
+static int TestScalar(const PackedPairs& pairs, int begin, int count, Scalar scale, uint64_t* hits)
+{
+	int found = 0;
+	for (int p = begin; p < count; p++)
+	{
+		uint64_t hit = Overlaps(pairs, p, scale) ? 1 : 0;
+		hits[p / 64] |= hit << (p % 64);
+		found += (int)hit;
+	}
+	return found;
+}
+
+#ifdef NARROWPHASE_X64
+
+// 2 pairs at a time
+static int TestSse2(const PackedPairs& pairs, int count, double scale, uint64_t* hits, int& found)
+{
+	__m128d scales = _mm_set1_pd(scale);
+
+	int p = 0;
+	for (; p + 2 <= count; p += 2)
+	{
+		__m128d dx = _mm_sub_pd(_mm_loadu_pd(pairs.firstX + p), _mm_loadu_pd(pairs.secondX + p));
+		__m128d dy = _mm_sub_pd(_mm_loadu_pd(pairs.firstY + p), _mm_loadu_pd(pairs.secondY + p));
+		__m128d distance = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+		__m128d radius = _mm_loadu_pd(pairs.radius + p);
+		__m128d limit = _mm_mul_pd(_mm_mul_pd(radius, radius), scales);
+
+		// p is even, so the 2 bits never straddle two words
+		int mask = _mm_movemask_pd(_mm_cmplt_pd(distance, limit));
+		hits[p / 64] |= (uint64_t)mask << (p % 64);
+		found += (mask & 1) + (mask >> 1);
+	}
+	return p;
+}
+
+// 4 pairs at a time
+TARGET_AVX2 static int TestAvx2(const PackedPairs& pairs, int count, double scale, uint64_t* hits, int& found)
+{
+	__m256d scales = _mm256_set1_pd(scale);
+
+	int p = 0;
+	for (; p + 4 <= count; p += 4)
+	{
+		__m256d dx = _mm256_sub_pd(_mm256_loadu_pd(pairs.firstX + p), _mm256_loadu_pd(pairs.secondX + p));
+		__m256d dy = _mm256_sub_pd(_mm256_loadu_pd(pairs.firstY + p), _mm256_loadu_pd(pairs.secondY + p));
+		__m256d distance = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+		__m256d radius = _mm256_loadu_pd(pairs.radius + p);
+		__m256d limit = _mm256_mul_pd(_mm256_mul_pd(radius, radius), scales);
+
+		// p is a multiple of 4, so the 4 bits never straddle two words
+		int mask = _mm256_movemask_pd(_mm256_cmp_pd(distance, limit, _CMP_LT_OQ));
+		hits[p / 64] |= (uint64_t)mask << (p % 64);
+		found += (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + (mask >> 3);
+	}
+	return p;
+}
+
+#endif
+
+void OverlapBatch::Clear()
+{
+	first.clear();
+	second.clear();
+}
+
+void OverlapBatch::Add(int firstIndex, int secondIndex)
+{
+	first.push_back(firstIndex);
+	second.push_back(secondIndex);
+}
+
+int OverlapBatch::GetCount()
+{
+	return (int)first.size();
+}
+
+int OverlapBatch::GetFirst(int pair)
+{
+	return first[pair];
+}
+
+int OverlapBatch::GetSecond(int pair)
+{
+	return second[pair];
+}
+
+void OverlapBatch::Pack(const CircleSet& a, const CircleSet& b)
+{
+	int count = GetCount();
+	firstX.resize(count);
+	firstY.resize(count);
+	secondX.resize(count);
+	secondY.resize(count);
+	radius.resize(count);
+	for (int p = 0; p < count; p++)
+	{
+		int i = first[p];
+		int j = second[p];
+		firstX[p] = a.x[i];
+		firstY[p] = a.y[i];
+		secondX[p] = b.x[j];
+		secondY[p] = b.y[j];
+		radius[p] = (a.radius != NULL ? a.radius[i] : Scalar(0)) + (b.radius != NULL ? b.radius[j] : Scalar(0));
+	}
+}
+
+int OverlapBatch::TestPacked(Scalar scale, SimdLevel level)
+{
+	if (level > GetSimdLevel())
+	{
+		level = GetSimdLevel();
+	}
+
+	int count = GetCount();
+	hits.assign((count + 63) / 64, 0);
+
+	PackedPairs pairs;
+	pairs.firstX = firstX.data();
+	pairs.firstY = firstY.data();
+	pairs.secondX = secondX.data();
+	pairs.secondY = secondY.data();
+	pairs.radius = radius.data();
+
+	// The vector loops stop at the last full vector, the scalar loop does the rest
+	int found = 0;
+	int done = 0;
+#ifdef NARROWPHASE_X64
+	if (level == SIMD_AVX2)
+		done = TestAvx2(pairs, count, scale, hits.data(), found);
+	else if (level == SIMD_SSE2)
+		done = TestSse2(pairs, count, scale, hits.data(), found);
+#endif
+	return found + TestScalar(pairs, done, count, scale, hits.data());
+}
+
+int OverlapBatch::Test(const CircleSet& a, const CircleSet& b, Scalar scale, SimdLevel level)
+{
+	Pack(a, b);
+	return TestPacked(scale, level);
+}
+
+bool OverlapBatch::IsHit(int pair)
+{
+	return (hits[pair / 64] >> (pair % 64)) & 1;
+}
+
+const uint64_t* OverlapBatch::GetHits()
+{
+	return hits.data();
+}
+
+// Earliest time in [0, 1) where two circles moving in straight lines are closer than radius, or -1 if they never are.
+// Relative to the second circle, the first one starts at (x, y) and moves by (dx, dy) during the tick
+static Scalar FirstContact(Scalar x, Scalar y, Scalar dx, Scalar dy, Scalar radiusSquared)
+{
+	Scalar start = x * x + y * y;
+	if (start < radiusSquared)
+	{
+		return 0;
+	}
+
+	// Moving apart, or not moving at all: they only get farther
+	Scalar along = x * dx + y * dy;
+	Scalar length = dx * dx + dy * dy;
+	if (along >= 0 || length == 0)
+	{
+		return -1;
+	}
+
+	// Closest approach, from the middle of the two contact times. It can be after the end of the tick,
+	// that's fine: the contact is then checked against the end below
+	Scalar closest = -along / length;
+	Scalar closestX = x + dx * closest;
+	Scalar closestY = y + dy * closest;
+	Scalar miss = closestX * closestX + closestY * closestY - radiusSquared;
+	if (miss >= 0)
+	{
+		return -1;
+	}
+
+	Scalar contact = closest - SquareRoot(-miss / length);
+	if (contact >= 1)
+	{
+		return -1;
+	}
+	return contact < 0 ? Scalar(0) : contact;
+}
+
+// Absolute value without the C library, so it's the same for doubles and fixed-point
+static inline Scalar Magnitude(Scalar value)
+{
+	return value < 0 ? -value : value;
+}
+
+void OverlapBatch::PackSwept(const CircleSet& a, const CircleSet& b, Scalar scale)
+{
+	// Each circle of a pair stands in for its whole path: centered on the middle of the path, grown by half its length.
+	// The length is over-estimated as |dx| + |dy| to stay away from square roots, and there's a pixel to spare for rounding,
+	// so the packed test never misses a pair the sweep would hit
+	Scalar radiusScale = SquareRoot(scale);
+	int count = GetCount();
+	firstX.resize(count);
+	firstY.resize(count);
+	secondX.resize(count);
+	secondY.resize(count);
+	radius.resize(count);
+	for (int p = 0; p < count; p++)
+	{
+		int i = first[p];
+		int j = second[p];
+		Scalar firstPreviousX = a.previousX != NULL ? a.previousX[i] : a.x[i];
+		Scalar firstPreviousY = a.previousY != NULL ? a.previousY[i] : a.y[i];
+		Scalar secondPreviousX = b.previousX != NULL ? b.previousX[j] : b.x[j];
+		Scalar secondPreviousY = b.previousY != NULL ? b.previousY[j] : b.y[j];
+		Scalar sum = (a.radius != NULL ? a.radius[i] : Scalar(0)) + (b.radius != NULL ? b.radius[j] : Scalar(0));
+		Scalar path = Magnitude(a.x[i] - firstPreviousX) + Magnitude(a.y[i] - firstPreviousY) +
+			Magnitude(b.x[j] - secondPreviousX) + Magnitude(b.y[j] - secondPreviousY);
+
+		firstX[p] = (firstPreviousX + a.x[i]) / 2;
+		firstY[p] = (firstPreviousY + a.y[i]) / 2;
+		secondX[p] = (secondPreviousX + b.x[j]) / 2;
+		secondY[p] = (secondPreviousY + b.y[j]) / 2;
+		radius[p] = sum * radiusScale + path / 2 + 1;
+	}
+}
+
+int OverlapBatch::Sweep(const CircleSet& a, const CircleSet& b, Scalar scale, SimdLevel level)
+{
+	// The packed test throws out the pairs whose paths are nowhere near each other, at the SIMD level asked for.
+	// Only the ones left are swept exactly, so every level finds the same hits at the same times
+	PackSwept(a, b, scale);
+	TestPacked(1, level);
+
+	int count = GetCount();
+	times.resize(count);
+
+	int found = 0;
+	for (int p = 0; p < count; p++)
+	{
+		times[p] = -1;
+		if (!IsHit(p))
+		{
+			continue;
+		}
+
+		int i = first[p];
+		int j = second[p];
+		Scalar firstPreviousX = a.previousX != NULL ? a.previousX[i] : a.x[i];
+		Scalar firstPreviousY = a.previousY != NULL ? a.previousY[i] : a.y[i];
+		Scalar secondPreviousX = b.previousX != NULL ? b.previousX[j] : b.x[j];
+		Scalar secondPreviousY = b.previousY != NULL ? b.previousY[j] : b.y[j];
+		Scalar sum = (a.radius != NULL ? a.radius[i] : Scalar(0)) + (b.radius != NULL ? b.radius[j] : Scalar(0));
+
+		// Both move, so the first one moves by the difference of the two motions as seen from the second
+		Scalar x = firstPreviousX - secondPreviousX;
+		Scalar y = firstPreviousY - secondPreviousY;
+		Scalar dx = (a.x[i] - firstPreviousX) - (b.x[j] - secondPreviousX);
+		Scalar dy = (a.y[i] - firstPreviousY) - (b.y[j] - secondPreviousY);
+		times[p] = FirstContact(x, y, dx, dy, sum * sum * scale);
+		if (times[p] >= 0)
+		{
+			found++;
+		}
+		else
+		{
+			hits[p / 64] &= ~((uint64_t)1 << (p % 64));
+		}
+	}
+	return found;
+}
+
+Scalar OverlapBatch::GetTime(int pair)
+{
+	return times[pair];
+}
+
+// Even-odd rule: the point is inside if a ray going right from it crosses the outline an odd number of times
+static bool InsideOutline(const Scalar* outlineX, const Scalar* outlineY, int corners, Scalar x, Scalar y)
+{
+	bool inside = false;
+	for (int i = 0, j = corners - 1; i < corners; j = i++)
+	{
+		if ((outlineY[i] > y) != (outlineY[j] > y))
+		{
+			// Where the edge crosses the ray's line
+			Scalar crossX = outlineX[i] + (outlineX[j] - outlineX[i]) * (y - outlineY[i]) / (outlineY[j] - outlineY[i]);
+			if (x < crossX)
+			{
+				inside = !inside;
+			}
+		}
+	}
+	return inside;
+}
+
+Scalar FirstContactInOutline(const Scalar* outlineX, const Scalar* outlineY, int corners, Scalar startX, Scalar startY, Scalar endX, Scalar endY)
+{
+	if (InsideOutline(outlineX, outlineY, corners, startX, startY))
+	{
+		return 0;
+	}
+
+	// The first edge the path crosses. Path and edge meet at start + t * path = corner + u * edge
+	Scalar pathX = endX - startX;
+	Scalar pathY = endY - startY;
+	Scalar first = -1;
+	for (int i = 0, j = corners - 1; i < corners; j = i++)
+	{
+		Scalar edgeX = outlineX[i] - outlineX[j];
+		Scalar edgeY = outlineY[i] - outlineY[j];
+		Scalar denominator = pathX * edgeY - pathY * edgeX;
+		if (denominator == 0)
+		{
+			// Parallel: if they overlap, the path crosses the neighbouring edges too
+			continue;
+		}
+
+		Scalar toCornerX = outlineX[j] - startX;
+		Scalar toCornerY = outlineY[j] - startY;
+		Scalar t = (toCornerX * edgeY - toCornerY * edgeX) / denominator;
+		Scalar u = (toCornerX * pathY - toCornerY * pathX) / denominator;
+		if (t >= 0 && t < 1 && u >= 0 && u <= 1 && (first < 0 || t < first))
+		{
+			first = t;
+		}
+	}
+	return first;
+}
+
+// True if an axis perpendicular to one of a's edges has a and b on either side of it
+static bool SeparatedByEdgeOf(const Scalar* aX, const Scalar* aY, const Scalar* bX, const Scalar* bY)
+{
+	for (int i = 0, j = 2; i < 3; j = i++)
+	{
+		Scalar axisX = aY[i] - aY[j];
+		Scalar axisY = aX[j] - aX[i];
+
+		Scalar minA = aX[0] * axisX + aY[0] * axisY;
+		Scalar maxA = minA;
+		Scalar minB = bX[0] * axisX + bY[0] * axisY;
+		Scalar maxB = minB;
+		for (int k = 1; k < 3; k++)
+		{
+			Scalar projectionA = aX[k] * axisX + aY[k] * axisY;
+			Scalar projectionB = bX[k] * axisX + bY[k] * axisY;
+			minA = projectionA < minA ? projectionA : minA;
+			maxA = projectionA > maxA ? projectionA : maxA;
+			minB = projectionB < minB ? projectionB : minB;
+			maxB = projectionB > maxB ? projectionB : maxB;
+		}
+
+		// Touching doesn't count, like the circle tests
+		if (maxA <= minB || maxB <= minA)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool TriangleOverlapsOutline(const Scalar* outlineX, const Scalar* outlineY, int corners, const Scalar* triangleX, const Scalar* triangleY)
+{
+	for (int i = 0, j = corners - 1; i < corners; j = i++)
+	{
+		Scalar pieceX[3] = { 0, outlineX[j], outlineX[i] };
+		Scalar pieceY[3] = { 0, outlineY[j], outlineY[i] };
+		if (!SeparatedByEdgeOf(pieceX, pieceY, triangleX, triangleY) && !SeparatedByEdgeOf(triangleX, triangleY, pieceX, pieceY))
+		{
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "Motion.h"
+
+// Circles to test, as component arrays. Pairs refer to them by index
+struct CircleSet
+{
+	const Scalar* x;
+	const Scalar* y;
+	// NULL for points
+	const Scalar* radius;
+	// Where the circles were at the start of the tick, for sweeping. NULL for circles that didn't move
+	const Scalar* previousX;
+	const Scalar* previousY;
+};
+
+// Exact tests against an outline in its own space: corners in order around (0, 0), every one of them visible from (0, 0),
+// like an asteroid's. They're meant for the few pairs whose bounding circles already touch.
+
+// When a point moving in a straight line from start to end first gets inside the outline, as a fraction of the way:
+// 0 if it starts inside, otherwise where it first crosses an edge. -1 if it never gets in
+Scalar FirstContactInOutline(const Scalar* outlineX, const Scalar* outlineY, int corners, Scalar startX, Scalar startY, Scalar endX, Scalar endY);
+// True if the triangle and the outline overlap. The outline is cut into one triangle per edge, from (0, 0), so every piece is convex
+// even when the outline isn't, and the triangle is tested against each piece with separating axes
+bool TriangleOverlapsOutline(const Scalar* outlineX, const Scalar* outlineY, int corners, const Scalar* triangleX, const Scalar* triangleY);
+
+// Candidate pairs from a broadphase, tested all at once.
+// Circles a and b of a pair overlap when the squared distance between their centers is below (radius a + radius b)^2 * scale.
+// The pairs' centers and radii are first copied into packed arrays, one after the other, so the test itself only streams through memory.
+// Each SIMD level tests 1, 2 or 4 pairs per instruction, with the same operations in the same order, so they all find exactly the same hits
+class OverlapBatch
+{
+public:
+	void Clear();
+	void Add(int first, int second);
+
+	int GetCount();
+	int GetFirst(int pair);
+	int GetSecond(int pair);
+
+	// Tests every pair, returns how many overlap. Levels above GetSimdLevel() fall back to it
+	int Test(const CircleSet& a, const CircleSet& b, Scalar scale, SimdLevel level = GetSimdLevel());
+	// The two halves of Test: copying the circles of every pair into the packed arrays, then testing them
+	void Pack(const CircleSet& a, const CircleSet& b);
+	int TestPacked(Scalar scale, SimdLevel level = GetSimdLevel());
+	bool IsHit(int pair);
+	// Bit pair % 64 of word pair / 64 is set if the pair overlaps
+	const uint64_t* GetHits();
+
+	// Like Test, but over the whole tick: both circles of a pair move in a straight line from their previous position to
+	// their current one, and they hit if they overlap at any time along the way. Fast things can't jump over each other,
+	// however long the tick. Circles that wrapped around the screen are swept from their previous position as moved by the wrap,
+	// like interpolation does. The pairs first go through the packed test, as circles grown to cover their whole path,
+	// and only the ones that pass are swept exactly
+	int Sweep(const CircleSet& a, const CircleSet& b, Scalar scale, SimdLevel level = GetSimdLevel());
+	// For a pair that hit in Sweep, when they first touched: 0 at the start of the tick, 1 at the end
+	Scalar GetTime(int pair);
+
+private:
+	// Like Pack, for Sweep: each circle covers its path over the tick, its radius scaled by the square root of scale
+	void PackSwept(const CircleSet& a, const CircleSet& b, Scalar scale);
+
+	std::vector<int> first;
+	std::vector<int> second;
+
+	// Packed pairs: both centers, and the sum of the radii
+	std::vector<Scalar> firstX;
+	std::vector<Scalar> firstY;
+	std::vector<Scalar> secondX;
+	std::vector<Scalar> secondY;
+	std::vector<Scalar> radius;
+	std::vector<uint64_t> hits;
+	std::vector<Scalar> times;
+};
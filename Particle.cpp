@@ -0,0 +1,162 @@
+#include "World.h"
+#include "Particle.h"
+
+ParticlePool::ParticlePool(int capacity) : capacity(capacity), head(0), count(0)
+{
+	x.resize(capacity);
+	y.resize(capacity);
+	previousX.resize(capacity);
+	previousY.resize(capacity);
+	speedX.resize(capacity);
+	speedY.resize(capacity);
+	age.resize(capacity);
+	kind.resize(capacity);
+}
+
+ParticlePool::~ParticlePool()
+{
+}
+
+int ParticlePool::Slot(int index)
+{
+	int slot = head + index;
+	return slot < capacity ? slot : slot - capacity;
+}
+
+void ParticlePool::SpawnBurst(ParticleKind newKind, Scalar newX, Scalar newY, const Scalar* speeds, int burstCount)
+{
+	int angleStep = 360 / burstCount;
+	for (int i = 0; i < burstCount && capacity > 0; i++)
+	{
+		if (count == capacity)
+		{
+			// Full: the oldest particle goes
+			head = Slot(1);
+			count--;
+		}
+
+		int slot = Slot(count);
+		count++;
+
+		x[slot] = newX;
+		y[slot] = newY;
+		previousX[slot] = newX;
+		previousY[slot] = newY;
+		speedX[slot] = speeds[i] * SinDegrees(i * angleStep);
+		speedY[slot] = -speeds[i] * CosDegrees(i * angleStep);
+		age[slot] = 0;
+		kind[slot] = (unsigned char)newKind;
+	}
+}
+
+void ParticlePool::AdvanceRun(int begin, int end, Scalar elapsedTime)
+{
+	// Plain arrays in, plain arrays out, no branches: the compiler vectorizes this
+	Scalar* px = x.data();
+	Scalar* py = y.data();
+	Scalar* ppx = previousX.data();
+	Scalar* ppy = previousY.data();
+	const Scalar* sx = speedX.data();
+	const Scalar* sy = speedY.data();
+	Scalar* pa = age.data();
+	for (int i = begin; i < end; i++)
+	{
+		ppx[i] = px[i];
+		ppy[i] = py[i];
+		px[i] = px[i] + elapsedTime * sx[i];
+		py[i] = py[i] + elapsedTime * sy[i];
+		pa[i] = pa[i] + elapsedTime;
+	}
+}
+
+void ParticlePool::Advance(Scalar elapsedTime)
+{
+	// The live particles are at most two runs of the ring
+	int end = head + count;
+	AdvanceRun(head, end < capacity ? end : capacity, elapsedTime);
+	if (end > capacity)
+	{
+		AdvanceRun(0, end - capacity, elapsedTime);
+	}
+
+	// The oldest are at the front, so the expired ones are a run from the front too
+	int expired = 0;
+	while (expired < count && age[Slot(expired)] >= PARTICLE_LIFETIME)
+	{
+		expired++;
+	}
+	head = Slot(expired);
+	count -= expired;
+}
+
+void ParticlePool::Clear()
+{
+	head = 0;
+	count = 0;
+}
+
+void ParticlePool::SaveState(StateWriter& writer)
+{
+	writer.Write(capacity);
+	writer.Write(head);
+	writer.Write(count);
+	writer.WriteArray(x.data(), capacity);
+	writer.WriteArray(y.data(), capacity);
+	writer.WriteArray(previousX.data(), capacity);
+	writer.WriteArray(previousY.data(), capacity);
+	writer.WriteArray(speedX.data(), capacity);
+	writer.WriteArray(speedY.data(), capacity);
+	writer.WriteArray(age.data(), capacity);
+	writer.WriteArray(kind.data(), capacity);
+}
+
+void ParticlePool::LoadState(StateReader& reader)
+{
+	int savedCapacity = 0;
+	reader.Read(savedCapacity);
+	if (savedCapacity != capacity)
+	{
+		reader.Fail();
+		return;
+	}
+
+	// Slot() only wraps around once, a head or count past the ring would index outside it
+	int savedHead = 0;
+	int savedCount = 0;
+	reader.Read(savedHead);
+	reader.Read(savedCount);
+	if (!reader.IsValid() || savedHead < 0 || (savedHead >= capacity && savedHead != 0) || savedCount < 0 || savedCount > capacity)
+	{
+		reader.Fail();
+		return;
+	}
+	head = savedHead;
+	count = savedCount;
+	reader.ReadArray(x.data(), capacity);
+	reader.ReadArray(y.data(), capacity);
+	reader.ReadArray(previousX.data(), capacity);
+	reader.ReadArray(previousY.data(), capacity);
+	reader.ReadArray(speedX.data(), capacity);
+	reader.ReadArray(speedY.data(), capacity);
+	reader.ReadArray(age.data(), capacity);
+	reader.ReadArray(kind.data(), capacity);
+}
+
+int ParticlePool::GetCount()
+{
+	return count;
+}
+
+ParticleKind ParticlePool::GetKind(int index)
+{
+	return (ParticleKind)kind[Slot(index)];
+}
+
+Point2D ParticlePool::GetInterpolatedPosition(int index, double alpha)
+{
+	int slot = Slot(index);
+	Point2D position;
+	position.x = Interpolate(ScalarToDouble(previousX[slot]), ScalarToDouble(x[slot]), alpha);
+	position.y = Interpolate(ScalarToDouble(previousY[slot]), ScalarToDouble(y[slot]), alpha);
+	return position;
+}
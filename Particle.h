@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+#include "Point2D.h"
+#include "Scalar.h"
+#include "StateBuffer.h"
+
+// Seconds every particle lives
+#define PARTICLE_LIFETIME SCALAR(0.5)
+// Enough for a dozen explosions at the same time
+#define PARTICLE_CAPACITY 256
+
+// What the particle is debris of, so drawing can tell them apart
+enum ParticleKind
+{
+	PARTICLE_SHIP,
+	PARTICLE_ASTEROID
+};
+
+// Explosion debris, purely for show: nothing collides with it.
+// Particles live in a fixed-capacity ring buffer, one array per component, so the whole pool moves in one straight pass.
+// They all live PARTICLE_LIFETIME, so they expire in the order they were spawned, and the expired ones are dropped from the front all at once.
+// The buffer is allocated once; when it's full, the oldest particles make room for new ones
+class ParticlePool
+{
+public:
+	ParticlePool(int capacity = PARTICLE_CAPACITY);
+	~ParticlePool();
+
+	// Adds count particles at (x, y), going out in evenly spread directions, the first one straight up, each at its own speed
+	void SpawnBurst(ParticleKind kind, Scalar x, Scalar y, const Scalar* speeds, int count);
+	void Advance(Scalar elapsedTime);
+	void Clear();
+	// The whole ring is saved, so the size of the state only depends on the capacity
+	void SaveState(StateWriter& writer);
+	void LoadState(StateReader& reader);
+
+	// Indices go from the oldest particle to the newest
+	int GetCount();
+	ParticleKind GetKind(int index);
+	Point2D GetInterpolatedPosition(int index, double alpha);
+
+private:
+	int Slot(int index);
+	void AdvanceRun(int begin, int end, Scalar elapsedTime);
+
+	int capacity;
+	int head;
+	int count;
+
+	std::vector<Scalar> x;
+	std::vector<Scalar> y;
+	std::vector<Scalar> previousX;
+	std::vector<Scalar> previousY;
+	std::vector<Scalar> speedX;
+	std::vector<Scalar> speedY;
+	std::vector<Scalar> age;
+	std::vector<unsigned char> kind;
+};
@@ -4,4 +4,4 @@ struct Point2D
 {
 	double x;
 	double y;
-};
\ No newline at end of file
+};
@@ -1,60 +1,275 @@
-#include "framework.h"
-#include "Engine.h"
+#include <math.h>
+#include "World.h"
 #include "Projectile.h"
 
-Projectile::Projectile(Point2D startPosition, double rotationAngle) : m_pRedBrush(NULL)
+ProjectileField::ProjectileField(int capacity, double timeToLive, double range) :
+	capacity(capacity), head(0), count(0), aliveCount(0)
 {
+	double seconds = timeToLive;
+	if (range / PROJECTILE_SPEED < seconds)
+	{
+		seconds = range / PROJECTILE_SPEED;
+	}
+	lifetime = ScalarFromDouble(seconds);
+
+	x.resize(capacity);
+	y.resize(capacity);
+	previousX.resize(capacity);
+	previousY.resize(capacity);
+	speedX.resize(capacity);
+	speedY.resize(capacity);
+	age.resize(capacity);
+	alive.resize(capacity);
+}
+
+ProjectileField::~ProjectileField()
+{
+}
+
+int ProjectileField::Slot(int index)
+{
+	int slot = head + index;
+	return slot < capacity ? slot : slot - capacity;
+}
+
+bool ProjectileField::Spawn(Point2D startPosition, double rotationAngle)
+{
+	if (aliveCount >= capacity)
+	{
+		return false;
+	}
+	if (count == capacity)
+	{
+		// Every slot is taken, but some hold dead projectiles: squeeze them out
+		Compact();
+	}
+
+	int slot = Slot(count);
+	count++;
+	aliveCount++;
+
 	// Initilize a projectile from received parameter
-	position = startPosition;
+	x[slot] = ScalarFromDouble(startPosition.x);
+	y[slot] = ScalarFromDouble(startPosition.y);
+	previousX[slot] = x[slot];
+	previousY[slot] = y[slot];
+	age[slot] = 0;
+	alive[slot] = 1;
 
 	// Initialize the speed from a rotation angle
-	speed.x = sin(rotationAngle * PI / 180) * PROJECTILE_SPEED;
-	speed.y = -cos(rotationAngle * PI / 180) * PROJECTILE_SPEED;
+	Scalar angle = ScalarFromDouble(rotationAngle);
+	speedX[slot] = SinDegrees(angle) * PROJECTILE_SPEED;
+	speedY[slot] = -CosDegrees(angle) * PROJECTILE_SPEED;
 
+	return true;
 }
 
-Projectile::~Projectile()
+void ProjectileField::Compact()
 {
-	SafeRelease(&m_pRedBrush);
+	// Moves the live projectiles together at the front, keeping their order
+	int kept = 0;
+	for (int i = 0; i < count; i++)
+	{
+		int from = Slot(i);
+		if (alive[from])
+		{
+			int to = Slot(kept);
+			x[to] = x[from];
+			y[to] = y[from];
+			previousX[to] = previousX[from];
+			previousY[to] = previousY[from];
+			speedX[to] = speedX[from];
+			speedY[to] = speedY[from];
+			age[to] = age[from];
+			alive[to] = 1;
+			kept++;
+		}
+	}
+	for (int i = kept; i < count; i++)
+	{
+		alive[Slot(i)] = 0;
+	}
+	count = kept;
+}
+
+void ProjectileField::Remove(int index)
+{
+	int slot = Slot(index);
+	if (alive[slot])
+	{
+		alive[slot] = 0;
+		aliveCount--;
+	}
 }
 
-void Projectile::InitializeD2D(ID2D1HwndRenderTarget* m_pRenderTarget)
+void ProjectileField::Clear()
 {
-	// Creates a red brush for drawing
-	m_pRenderTarget->CreateSolidColorBrush(
-		D2D1::ColorF(D2D1::ColorF::Red),
-		&m_pRedBrush
-	);
+	for (int i = 0; i < count; i++)
+	{
+		alive[Slot(i)] = 0;
+	}
+	head = 0;
+	count = 0;
+	aliveCount = 0;
 }
 
-void Projectile::Advance(double elapsedTime)
+void ProjectileField::SaveState(StateWriter& writer)
 {
-	// Projectile moves
-	position.x += elapsedTime * speed.x;
-	position.y += elapsedTime * speed.y;
+	writer.Write(capacity);
+	writer.Write(head);
+	writer.Write(count);
+	writer.Write(aliveCount);
+	writer.WriteArray(x.data(), capacity);
+	writer.WriteArray(y.data(), capacity);
+	writer.WriteArray(previousX.data(), capacity);
+	writer.WriteArray(previousY.data(), capacity);
+	writer.WriteArray(speedX.data(), capacity);
+	writer.WriteArray(speedY.data(), capacity);
+	writer.WriteArray(age.data(), capacity);
+	writer.WriteArray(alive.data(), capacity);
 }
 
-bool Projectile::IsOut()
+void ProjectileField::LoadState(StateReader& reader)
+{
+	// The ring was allocated for the engine's configuration, a state saved with another capacity doesn't fit
+	int savedCapacity = 0;
+	reader.Read(savedCapacity);
+	if (savedCapacity != capacity)
+	{
+		reader.Fail();
+		return;
+	}
+
+	// Slot() only wraps around once, a head or count past the ring would index outside it
+	int savedHead = 0;
+	int savedCount = 0;
+	int savedAliveCount = 0;
+	reader.Read(savedHead);
+	reader.Read(savedCount);
+	reader.Read(savedAliveCount);
+	if (!reader.IsValid() || savedHead < 0 || (savedHead >= capacity && savedHead != 0) || savedCount < 0 || savedCount > capacity ||
+		savedAliveCount < 0 || savedAliveCount > savedCount)
+	{
+		reader.Fail();
+		return;
+	}
+	head = savedHead;
+	count = savedCount;
+	aliveCount = savedAliveCount;
+	reader.ReadArray(x.data(), capacity);
+	reader.ReadArray(y.data(), capacity);
+	reader.ReadArray(previousX.data(), capacity);
+	reader.ReadArray(previousY.data(), capacity);
+	reader.ReadArray(speedX.data(), capacity);
+	reader.ReadArray(speedY.data(), capacity);
+	reader.ReadArray(age.data(), capacity);
+	reader.ReadArray(alive.data(), capacity);
+}
+
+void ProjectileField::Advance(Scalar elapsedTime)
+{
+	// Projectiles move in a straight line, they don't wrap around the screen.
+	// The ones that leave the screen or expire are still around until Expire, so collisions see their whole path
+	for (int i = 0; i < count; i++)
+	{
+		int slot = Slot(i);
+		if (!alive[slot])
+		{
+			continue;
+		}
+
+		previousX[slot] = x[slot];
+		previousY[slot] = y[slot];
+		x[slot] += elapsedTime * speedX[slot];
+		y[slot] += elapsedTime * speedY[slot];
+		age[slot] += elapsedTime;
+	}
+}
+
+void ProjectileField::Expire()
+{
+	for (int i = 0; i < count; i++)
+	{
+		if (IsAlive(i) && (IsOut(i) || age[Slot(i)] >= lifetime))
+		{
+			// Eliminate the projectile if it's outside the screen or lived long enough
+			Remove(i);
+		}
+	}
+
+	// The oldest projectiles are at the front: drop them while they are dead
+	while (count > 0 && !alive[head])
+	{
+		head = Slot(1);
+		count--;
+	}
+}
+
+bool ProjectileField::IsOut(int index)
 {
 	// Returns true if the projectile is out of the screen area so we can remove it
-	if (position.x < -10 || position.x > RESOLUTION_X + 10 || position.y < -10 || position.y > RESOLUTION_Y + 10)
+	int slot = Slot(index);
+	if (x[slot] < -SCREEN_MARGIN || x[slot] > RESOLUTION_X + SCREEN_MARGIN || y[slot] < -SCREEN_MARGIN || y[slot] > RESOLUTION_Y + SCREEN_MARGIN)
 	{
 		return true;
 	}
 	return false;
 }
 
-void Projectile::Draw(ID2D1HwndRenderTarget* m_pRenderTarget)
+CircleSet ProjectileField::GetCircles()
+{
+	CircleSet circles;
+	circles.x = x.data();
+	circles.y = y.data();
+	circles.radius = NULL;
+	circles.previousX = previousX.data();
+	circles.previousY = previousY.data();
+	return circles;
+}
+
+int ProjectileField::GetSlot(int index)
 {
-	// Draws the ball using Direct2D
-	D2D1_ELLIPSE ellipseBall = D2D1::Ellipse(
-		D2D1::Point2F(position.x, position.y),
-		5, 5
-	);
-	m_pRenderTarget->FillEllipse(&ellipseBall, m_pRedBrush);
+	return Slot(index);
+}
+
+int ProjectileField::GetCount()
+{
+	return count;
+}
+
+int ProjectileField::GetAliveCount()
+{
+	return aliveCount;
+}
+
+bool ProjectileField::IsAlive(int index)
+{
+	return alive[Slot(index)] != 0;
+}
+
+Point2D ProjectileField::GetPosition(int index)
+{
+	int slot = Slot(index);
+	Point2D position;
+	position.x = ScalarToDouble(x[slot]);
+	position.y = ScalarToDouble(y[slot]);
+	return position;
+}
+
+Point2D ProjectileField::GetPreviousPosition(int index)
+{
+	int slot = Slot(index);
+	Point2D position;
+	position.x = ScalarToDouble(previousX[slot]);
+	position.y = ScalarToDouble(previousY[slot]);
+	return position;
 }
 
-Point2D Projectile::GetPosition()
+Point2D ProjectileField::GetInterpolatedPosition(int index, double alpha)
 {
+	int slot = Slot(index);
+	Point2D position;
+	position.x = Interpolate(ScalarToDouble(previousX[slot]), ScalarToDouble(x[slot]), alpha);
+	position.y = Interpolate(ScalarToDouble(previousY[slot]), ScalarToDouble(y[slot]), alpha);
 	return position;
 }
\ No newline at end of file
@@ -1,28 +1,64 @@
 #pragma once
 
-#include "resource.h"
+#include <vector>
 #include "Point2D.h"
+#include "Scalar.h"
+#include "StateBuffer.h"
+#include "Narrowphase.h"
 
-#define PROJECTILE_SPEED 400;
+#define PROJECTILE_SPEED 400
 
-class Projectile
+// All the projectiles flying around, in a fixed-capacity ring buffer.
+// Projectiles are fired at the back and, since they all live for the same time, expire from the front.
+// The buffer is allocated once, so firing and expiring never touch the heap.
+// A projectile that hits something or leaves the screen is only marked dead; the slot is reclaimed when it reaches the front
+class ProjectileField
 {
 public:
-	Projectile(Point2D startPosition, double rotationAngle);
-	~Projectile();
+	ProjectileField(int capacity, double timeToLive, double range);
+	~ProjectileField();
 
-	void InitializeD2D(ID2D1HwndRenderTarget* m_pRenderTarget);
-	void Advance(double elapsedTime);
-	bool IsOut();
+	// Returns false if there are already as many projectiles as the capacity allows
+	bool Spawn(Point2D startPosition, double rotationAngle);
+	void Remove(int index);
+	void Clear();
+	void Advance(Scalar elapsedTime);
+	// Removes the projectiles that left the screen or expired in the last Advance. Call it once collisions are done with them
+	void Expire();
+	bool IsOut(int index);
+	// The whole ring is saved, so the size of the state only depends on the capacity
+	void SaveState(StateWriter& writer);
+	void LoadState(StateReader& reader);
 
-	void Draw(ID2D1HwndRenderTarget* m_pRenderTarget);
-
-	Point2D GetPosition();
+	// Indices go from the oldest projectile to the newest and stay the same until the next Expire or Spawn.
+	// Some of them can be dead, check IsAlive
+	int GetCount();
+	int GetAliveCount();
+	bool IsAlive(int index);
+	Point2D GetPosition(int index);
+	Point2D GetPreviousPosition(int index);
+	Point2D GetInterpolatedPosition(int index, double alpha);
+	// Projectiles as points for the narrowphase. The arrays are indexed by slot, not by index
+	CircleSet GetCircles();
+	int GetSlot(int index);
 
 private:
-	Point2D position;
-	Point2D speed;
+	int Slot(int index);
+	void Compact();
 
-	ID2D1SolidColorBrush* m_pRedBrush;
-};
+	int capacity;
+	int head;
+	int count;
+	int aliveCount;
+	// Seconds a projectile lives, from the time-to-live and the range, whichever ends first
+	Scalar lifetime;
 
+	std::vector<Scalar> x;
+	std::vector<Scalar> y;
+	std::vector<Scalar> previousX;
+	std::vector<Scalar> previousY;
+	std::vector<Scalar> speedX;
+	std::vector<Scalar> speedY;
+	std::vector<Scalar> age;
+	std::vector<char> alive;
+};
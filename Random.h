@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+
+// Small, fast random number generator (PCG32, O'Neill 2014).
+// Each Engine owns one, so games never share random state and the same seed always plays the same game
+class Random
+{
+public:
+	Random()
+	{
+		Seed(1);
+	}
+
+	Random(uint64_t seed)
+	{
+		Seed(seed);
+	}
+
+	void Seed(uint64_t seed)
+	{
+		// Standard PCG32 seeding, with a fixed stream
+		state = 0;
+		Next();
+		state += seed;
+		Next();
+	}
+
+	// Uniformly distributed 32 bits
+	uint32_t Next()
+	{
+		uint64_t oldState = state;
+		state = oldState * 6364136223846793005ULL + INCREMENT;
+		uint32_t xorShifted = (uint32_t)(((oldState >> 18) ^ oldState) >> 27);
+		uint32_t rotation = (uint32_t)(oldState >> 59);
+		return (xorShifted >> rotation) | (xorShifted << ((0u - rotation) & 31));
+	}
+
+	// Integer in [0, bound). Takes the place of rand() % bound
+	int NextInt(int bound)
+	{
+		return (int)(((uint64_t)Next() * (uint32_t)bound) >> 32);
+	}
+
+	// Double in [0, 1)
+	double NextDouble()
+	{
+		return (Next() >> 5) * (1.0 / 134217728.0);
+	}
+
+	// The whole generator is one number, so it can be saved and restored with the rest of the game
+	uint64_t GetState()
+	{
+		return state;
+	}
+
+	void SetState(uint64_t newState)
+	{
+		state = newState;
+	}
+
+private:
+	static const uint64_t INCREMENT = 1442695040888963407ULL;
+
+	uint64_t state;
+};
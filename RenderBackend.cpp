@@ -0,0 +1,95 @@
+#include "RenderBackend.h"
+
+NullBackend::NullBackend() : frames(0), commandCount(0), batchCount(0), checksum(0)
+{
+}
+
+void NullBackend::Submit(CommandList* commands)
+{
+	frames++;
+	for (int i = 0; i < commands->GetCount(); )
+	{
+		int end = commands->GetBatchEnd(i);
+		batchCount++;
+		for (; i < end; i++)
+		{
+			const RenderCommand& command = commands->GetCommand(i);
+			const RenderPoint* points = commands->GetPoints(command);
+			for (int p = 0; p < command.pointCount; p++)
+			{
+				checksum += points[p].x + points[p].y;
+			}
+			commandCount++;
+		}
+	}
+}
+
+long long NullBackend::GetFrames()
+{
+	return frames;
+}
+
+long long NullBackend::GetCommands()
+{
+	return commandCount;
+}
+
+long long NullBackend::GetBatches()
+{
+	return batchCount;
+}
+
+double NullBackend::GetChecksum()
+{
+	return checksum;
+}
+
+void RecordingBackend::Submit(CommandList* list)
+{
+	commands.clear();
+	points.clear();
+	for (int i = 0; i < list->GetCount(); i++)
+	{
+		RenderCommand command = list->GetCommand(i);
+		const RenderPoint* commandPoints = list->GetPoints(command);
+		command.firstPoint = (unsigned int)points.size();
+		points.insert(points.end(), commandPoints, commandPoints + command.pointCount);
+		commands.push_back(command);
+	}
+}
+
+int RecordingBackend::GetCount()
+{
+	return (int)commands.size();
+}
+
+const RenderCommand& RecordingBackend::GetCommand(int index)
+{
+	return commands[index];
+}
+
+const RenderPoint* RecordingBackend::GetPoints(const RenderCommand& command)
+{
+	return &points[command.firstPoint];
+}
+
+void RecordingBackend::WriteText(FILE* file)
+{
+	static const char* primitiveNames[PRIMITIVE_COUNT] = { "polyline", "triangle", "circle", "text" };
+	static const char* brushNames[BRUSH_COUNT] = { "white", "green", "orange", "blue", "yellow", "red" };
+
+	for (size_t i = 0; i < commands.size(); i++)
+	{
+		const RenderCommand& command = commands[i];
+		fprintf(file, "%s %s %.2f", primitiveNames[command.primitive], brushNames[command.brush], command.size);
+		if (command.text != NULL)
+		{
+			fprintf(file, " \"%s\"", command.text);
+		}
+		for (int p = 0; p < command.pointCount; p++)
+		{
+			fprintf(file, " %.2f,%.2f", points[command.firstPoint + p].x, points[command.firstPoint + p].y);
+		}
+		fprintf(file, "\n");
+	}
+}
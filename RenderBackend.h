@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdio.h>
+#include "CommandList.h"
+
+// Something that draws a frame's sorted command list
+class RenderBackend
+{
+public:
+	virtual ~RenderBackend()
+	{
+	}
+
+	virtual void Submit(CommandList* commands) = 0;
+};
+
+// Draws nothing, but walks the commands and points like a real backend would.
+// Used to measure what building and going through the list costs on the CPU
+class NullBackend : public RenderBackend
+{
+public:
+	NullBackend();
+
+	void Submit(CommandList* commands) override;
+
+	long long GetFrames();
+	long long GetCommands();
+	long long GetBatches();
+	// Sum of all the coordinates, so the walk can't be optimized away
+	double GetChecksum();
+
+private:
+	long long frames;
+	long long commandCount;
+	long long batchCount;
+	double checksum;
+};
+
+// Keeps a copy of the last frame it was given, in drawing order, and can write it out as text.
+// Two runs that should draw the same thing can be compared with a diff
+class RecordingBackend : public RenderBackend
+{
+public:
+	void Submit(CommandList* commands) override;
+
+	int GetCount();
+	const RenderCommand& GetCommand(int index);
+	const RenderPoint* GetPoints(const RenderCommand& command);
+
+	void WriteText(FILE* file);
+
+private:
+	std::vector<RenderCommand> commands;
+	std::vector<RenderPoint> points;
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "Ship.h"
+#include "Projectile.h"
+#include "Asteroid.h"
+#include "Particle.h"
+
+// Copy of everything the renderer draws, taken right after a simulation tick.
+// The simulation thread fills one while the renderer draws another (see TripleBuffer), so drawing never waits for the logic.
+// Copying into the same snapshot again reuses its memory, so after the first few ticks nothing is allocated
+struct RenderSnapshot
+{
+	RenderSnapshot() : projectiles(0, 0, 0), lives(0), gameOver(false), gameWon(false), tickTime(0), publishTime(0)
+	{
+	}
+
+	Ship ship;
+	ProjectileField projectiles;
+	AsteroidField asteroids;
+	ParticlePool particles;
+	int lives;
+	bool gameOver;
+	bool gameWon;
+
+	// Length of a tick, and when this one was published (in Clock time), to interpolate up to the next one
+	double tickTime;
+	long long publishTime;
+};
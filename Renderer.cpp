@@ -0,0 +1,193 @@
+#include "framework.h"
+#include "Engine.h"
+#include "Renderer.h"
+
+#pragma comment(lib, "d2d1")
+#pragma comment(lib, "dwrite")
+
+static_assert(sizeof(RenderPoint) == sizeof(D2D1_POINT_2F), "Command list points are handed to Direct2D as they are");
+
+Renderer::Renderer() : m_pDirect2dFactory(NULL), m_pRenderTarget(NULL), m_pDWriteFactory(NULL), m_pTextFormat(NULL)
+{
+    for (int i = 0; i < BRUSH_COUNT; i++)
+    {
+        m_pBrushes[i] = NULL;
+    }
+}
+
+Renderer::~Renderer()
+{
+    for (int i = 0; i < BRUSH_COUNT; i++)
+    {
+        SafeRelease(&m_pBrushes[i]);
+    }
+    SafeRelease(&m_pTextFormat);
+    SafeRelease(&m_pDWriteFactory);
+    SafeRelease(&m_pRenderTarget);
+    SafeRelease(&m_pDirect2dFactory);
+}
+
+HRESULT Renderer::InitializeD2D(HWND m_hwnd)
+{
+    // Initializes Direct2D, to draw with
+    D2D1_SIZE_U size = D2D1::SizeU(RESOLUTION_X, RESOLUTION_Y);
+    D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED, &m_pDirect2dFactory);
+    m_pDirect2dFactory->CreateHwndRenderTarget(
+        D2D1::RenderTargetProperties(),
+        D2D1::HwndRenderTargetProperties(m_hwnd, size, D2D1_PRESENT_OPTIONS_IMMEDIATELY),
+        &m_pRenderTarget
+    );
+
+    // Initialize text writing factory and format
+    DWriteCreateFactory(
+        DWRITE_FACTORY_TYPE_SHARED,
+        __uuidof(m_pDWriteFactory),
+        reinterpret_cast<IUnknown**>(&m_pDWriteFactory)
+    );
+
+    m_pDWriteFactory->CreateTextFormat(
+        L"Verdana",
+        NULL,
+        DWRITE_FONT_WEIGHT_NORMAL,
+        DWRITE_FONT_STYLE_NORMAL,
+        DWRITE_FONT_STRETCH_NORMAL,
+        60,
+        L"", //locale
+        &m_pTextFormat
+    );
+
+    m_pTextFormat->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_CENTER);
+
+    m_pTextFormat->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_CENTER);
+
+    // One brush per color, shared by all the entities
+    m_pRenderTarget->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::White), &m_pBrushes[BRUSH_WHITE]);
+    m_pRenderTarget->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::Green), &m_pBrushes[BRUSH_GREEN]);
+    m_pRenderTarget->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::Orange), &m_pBrushes[BRUSH_ORANGE]);
+    m_pRenderTarget->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::Blue), &m_pBrushes[BRUSH_BLUE]);
+    m_pRenderTarget->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::Yellow), &m_pBrushes[BRUSH_YELLOW]);
+    m_pRenderTarget->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::Red), &m_pBrushes[BRUSH_RED]);
+
+    return S_OK;
+}
+
+void Renderer::Submit(CommandList* commands)
+{
+    // This is the drawing method of the game.
+    // The commands come sorted by primitive and brush, so each group is drawn with one brush, mostly in one call
+    TRACE_SCOPE("Draw");
+    m_pRenderTarget->BeginDraw();
+    m_pRenderTarget->SetTransform(D2D1::Matrix3x2F::Identity());
+    m_pRenderTarget->Clear(D2D1::ColorF(D2D1::ColorF::Black));
+
+    for (int begin = 0; begin < commands->GetCount(); )
+    {
+        int end = commands->GetBatchEnd(begin);
+        const RenderCommand& first = commands->GetCommand(begin);
+        ID2D1SolidColorBrush* brush = m_pBrushes[first.brush];
+
+        switch (first.primitive)
+        {
+        case PRIMITIVE_POLYLINE:
+        {
+            TRACE_SCOPE("DrawPolylines");
+            // Outlines of different widths can't share a geometry
+            for (int i = begin; i < end; )
+            {
+                int sameWidthEnd = i + 1;
+                while (sameWidthEnd < end && commands->GetCommand(sameWidthEnd).size == commands->GetCommand(i).size)
+                {
+                    sameWidthEnd++;
+                }
+                DrawPathBatch(commands, i, sameWidthEnd, false);
+                i = sameWidthEnd;
+            }
+        }
+        break;
+
+        case PRIMITIVE_TRIANGLE:
+        {
+            TRACE_SCOPE("DrawTriangles");
+            DrawPathBatch(commands, begin, end, true);
+        }
+        break;
+
+        case PRIMITIVE_CIRCLE:
+        {
+            TRACE_SCOPE("DrawCircles");
+            for (int i = begin; i < end; i++)
+            {
+                const RenderCommand& command = commands->GetCommand(i);
+                const RenderPoint* center = commands->GetPoints(command);
+                D2D1_ELLIPSE ellipse = D2D1::Ellipse(D2D1::Point2F(center->x, center->y), command.size, command.size);
+                m_pRenderTarget->FillEllipse(&ellipse, brush);
+            }
+        }
+        break;
+
+        case PRIMITIVE_TEXT:
+        {
+            TRACE_SCOPE("DrawText");
+            for (int i = begin; i < end; i++)
+            {
+                const RenderCommand& command = commands->GetCommand(i);
+                const RenderPoint* corners = commands->GetPoints(command);
+
+                // Our texts are plain ASCII
+                WCHAR text[64];
+                int length = 0;
+                while (command.text[length] != 0 && length < 63)
+                {
+                    text[length] = (WCHAR)command.text[length];
+                    length++;
+                }
+                text[length] = 0;
+
+                D2D1_RECT_F rectangle = D2D1::RectF(corners[0].x, corners[0].y, corners[1].x, corners[1].y);
+                m_pRenderTarget->DrawText(text, length, m_pTextFormat, rectangle, brush);
+            }
+        }
+        break;
+        }
+
+        begin = end;
+    }
+
+    {
+        // Direct2D does the actual work here, and waits for the GPU if it's behind
+        TRACE_SCOPE("EndDraw");
+        m_pRenderTarget->EndDraw();
+    }
+}
+
+void Renderer::DrawPathBatch(CommandList* commands, int begin, int end, bool filled)
+{
+    // Every command becomes one figure of the same geometry
+    ID2D1PathGeometry* geometry = NULL;
+    if (FAILED(m_pDirect2dFactory->CreatePathGeometry(&geometry)))
+    {
+        return;
+    }
+
+    ID2D1GeometrySink* pclSink;
+    geometry->Open(&pclSink);
+    pclSink->SetFillMode(D2D1_FILL_MODE_WINDING);
+    for (int i = begin; i < end; i++)
+    {
+        const RenderCommand& command = commands->GetCommand(i);
+        const D2D1_POINT_2F* points = reinterpret_cast<const D2D1_POINT_2F*>(commands->GetPoints(command));
+        pclSink->BeginFigure(points[0], filled ? D2D1_FIGURE_BEGIN_FILLED : D2D1_FIGURE_BEGIN_HOLLOW);
+        pclSink->AddLines(points + 1, command.pointCount - 1);
+        pclSink->EndFigure(D2D1_FIGURE_END_CLOSED);
+    }
+    pclSink->Close();
+    SafeRelease(&pclSink);
+
+    const RenderCommand& first = commands->GetCommand(begin);
+    if (filled)
+        m_pRenderTarget->FillGeometry(geometry, m_pBrushes[first.brush]);
+    else
+        m_pRenderTarget->DrawGeometry(geometry, m_pBrushes[first.brush], first.size);
+
+    SafeRelease(&geometry);
+}
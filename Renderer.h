@@ -0,0 +1,26 @@
+#pragma once
+
+#include "RenderBackend.h"
+
+// Draws command lists with Direct2D.
+// All the brushes live here, one per color, and each group of commands is drawn with as few calls as Direct2D allows
+class Renderer : public RenderBackend
+{
+public:
+	Renderer();
+	~Renderer();
+
+	HRESULT InitializeD2D(HWND m_hwnd);
+	void Submit(CommandList* commands) override;
+
+private:
+	// Outlines or filled triangles of one group, as one geometry, so the whole group is a single draw call
+	void DrawPathBatch(CommandList* commands, int begin, int end, bool filled);
+
+	ID2D1Factory* m_pDirect2dFactory;
+	ID2D1HwndRenderTarget* m_pRenderTarget;
+
+	IDWriteFactory* m_pDWriteFactory;
+	IDWriteTextFormat* m_pTextFormat;
+	ID2D1SolidColorBrush* m_pBrushes[BRUSH_COUNT];
+};
@@ -0,0 +1,109 @@
+#include "Scalar.h"
+
+// Table steps in a quarter turn
+#define SINE_QUARTER_STEPS 1024
+// PI with 30 fractional bits
+#define PI_Q30 3373259426LL
+
+// Sine over a quarter turn, SINE_QUARTER_STEPS + 1 values with 16 fractional bits.
+// Built with a Taylor series in 64-bit integers, never with the C library, so it's the same everywhere
+class SineTable
+{
+public:
+	SineTable()
+	{
+		for (int step = 0; step <= SINE_QUARTER_STEPS; step++)
+		{
+			// Angle and its square with 30 fractional bits. The angle is at most PI / 2, so every product fits
+			int64_t angle = step * (PI_Q30 / 2) / SINE_QUARTER_STEPS;
+			int64_t squared = (angle * angle) >> 30;
+			int64_t term = angle;
+			int64_t sum = angle;
+			for (int n = 1; n <= 10; n++)
+			{
+				term = -((term * squared) >> 30) / ((2 * n) * (2 * n + 1));
+				sum += term;
+			}
+			values[step] = (sum + (1 << 13)) >> 14;
+		}
+	}
+
+	// Sine at position steps into the quarter turn, with 16 fractional bits of step, interpolated between the two nearest values
+	int64_t Quarter(int64_t position) const
+	{
+		int64_t step = position >> 16;
+		if (step >= SINE_QUARTER_STEPS)
+		{
+			return values[SINE_QUARTER_STEPS];
+		}
+		int64_t fraction = position & 0xFFFF;
+		return values[step] + (((values[step + 1] - values[step]) * fraction) >> 16);
+	}
+
+private:
+	int64_t values[SINE_QUARTER_STEPS + 1];
+};
+
+Fixed FixedSinDegrees(Fixed degrees)
+{
+	static const SineTable table;
+	static const int64_t fullTurn = (int64_t)360 * Fixed::ONE;
+	static const int64_t quarter = (int64_t)SINE_QUARTER_STEPS << 16;
+
+	int64_t angle = degrees.GetRaw() % fullTurn;
+	if (angle < 0)
+	{
+		angle += fullTurn;
+	}
+
+	// Position in the whole turn, in table steps with 16 fractional bits
+	int64_t position = angle * (4 * SINE_QUARTER_STEPS) / 360;
+	int64_t value;
+	if (position < quarter)
+		value = table.Quarter(position);
+	else if (position < 2 * quarter)
+		value = table.Quarter(2 * quarter - position);
+	else if (position < 3 * quarter)
+		value = -table.Quarter(position - 2 * quarter);
+	else
+		value = -table.Quarter(4 * quarter - position);
+
+	// The table has 16 fractional bits, like Fixed
+	return Fixed::FromRaw(value);
+}
+
+Fixed FixedCosDegrees(Fixed degrees)
+{
+	return FixedSinDegrees(degrees + 90);
+}
+
+Fixed FixedSquareRoot(Fixed value)
+{
+	if (value.GetRaw() <= 0)
+	{
+		return 0;
+	}
+
+	// The root of raw * ONE has 16 fractional bits again. Bit by bit, from the highest one the result can have
+	uint64_t remainder = (uint64_t)value.GetRaw() << Fixed::FRACTION_BITS;
+	uint64_t root = 0;
+	uint64_t bit = (uint64_t)1 << 62;
+	while (bit > remainder)
+	{
+		bit >>= 2;
+	}
+	while (bit != 0)
+	{
+		if (remainder >= root + bit)
+		{
+			remainder -= root + bit;
+			root = (root >> 1) + bit;
+		}
+		else
+		{
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+	return Fixed::FromRaw((int64_t)root);
+}
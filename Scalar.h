@@ -0,0 +1,182 @@
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+
+// Number with 16 fractional bits in a 64-bit integer.
+// Only integer operations, so every compiler and CPU gets exactly the same results.
+// Good to about 1/65536 for values up to a few tens of thousands, and products of two values up to about 2^31
+class Fixed
+{
+public:
+	static const int FRACTION_BITS = 16;
+	static const int64_t ONE = (int64_t)1 << FRACTION_BITS;
+
+	Fixed() : raw(0)
+	{
+	}
+
+	// Whole numbers convert exactly, and without asking
+	Fixed(int value) : raw((int64_t)value * ONE)
+	{
+	}
+
+	// Doubles have to go through FromDouble, so a 0.5 never quietly becomes a 0
+	Fixed(double value) = delete;
+	Fixed(float value) = delete;
+
+	static Fixed FromRaw(int64_t value)
+	{
+		Fixed result;
+		result.raw = value;
+		return result;
+	}
+
+	// Rounds to the nearest step. Doubles that came from a Fixed come back exactly
+	static Fixed FromDouble(double value)
+	{
+		return FromRaw((int64_t)floor(value * ONE + 0.5));
+	}
+
+	double ToDouble() const
+	{
+		return (double)raw / ONE;
+	}
+
+	int64_t GetRaw() const
+	{
+		return raw;
+	}
+
+	Fixed operator-() const
+	{
+		return FromRaw(-raw);
+	}
+
+	Fixed& operator+=(Fixed other)
+	{
+		raw += other.raw;
+		return *this;
+	}
+
+	Fixed& operator-=(Fixed other)
+	{
+		raw -= other.raw;
+		return *this;
+	}
+
+	// Rounds down, like the shift does
+	Fixed& operator*=(Fixed other)
+	{
+		raw = (raw * other.raw) >> FRACTION_BITS;
+		return *this;
+	}
+
+	// Rounds toward zero, like integer division does
+	Fixed& operator/=(Fixed other)
+	{
+		raw = (raw * ONE) / other.raw;
+		return *this;
+	}
+
+	friend Fixed operator+(Fixed a, Fixed b) { return a += b; }
+	friend Fixed operator-(Fixed a, Fixed b) { return a -= b; }
+	friend Fixed operator*(Fixed a, Fixed b) { return a *= b; }
+	friend Fixed operator/(Fixed a, Fixed b) { return a /= b; }
+	friend bool operator==(Fixed a, Fixed b) { return a.raw == b.raw; }
+	friend bool operator!=(Fixed a, Fixed b) { return a.raw != b.raw; }
+	friend bool operator<(Fixed a, Fixed b) { return a.raw < b.raw; }
+	friend bool operator>(Fixed a, Fixed b) { return a.raw > b.raw; }
+	friend bool operator<=(Fixed a, Fixed b) { return a.raw <= b.raw; }
+	friend bool operator>=(Fixed a, Fixed b) { return a.raw >= b.raw; }
+
+private:
+	int64_t raw;
+};
+
+// Sine and cosine of an angle in degrees, from a table built with integer arithmetic only.
+// Within about 2/65536 of the real thing
+Fixed FixedSinDegrees(Fixed degrees);
+Fixed FixedCosDegrees(Fixed degrees);
+// Rounded down to the step below, 0 for negative values
+Fixed FixedSquareRoot(Fixed value);
+
+// The type the physics (ship, asteroids, projectiles) computes with.
+// Builds with ASTEROIDS_FIXED_POINT use Fixed, so replays and lockstep sessions play out bit for bit the same on MSVC, GCC and Clang,
+// and on any CPU. Otherwise it's a double, which is faster, and the SIMD kernels can be used.
+// Positions and speeds leave the physics as doubles (Point2D), which hold any Fixed exactly
+#ifdef ASTEROIDS_FIXED_POINT
+
+typedef Fixed Scalar;
+
+// A constant with a fractional part, like SCALAR(1.5)
+#define SCALAR(value) Fixed::FromDouble(value)
+
+inline Scalar ScalarFromDouble(double value)
+{
+	return Fixed::FromDouble(value);
+}
+
+inline double ScalarToDouble(Scalar value)
+{
+	return value.ToDouble();
+}
+
+inline Scalar SinDegrees(Scalar degrees)
+{
+	return FixedSinDegrees(degrees);
+}
+
+inline Scalar CosDegrees(Scalar degrees)
+{
+	return FixedCosDegrees(degrees);
+}
+
+inline Scalar SquareRoot(Scalar value)
+{
+	return FixedSquareRoot(value);
+}
+
+#else
+
+typedef double Scalar;
+
+#define SCALAR(value) (value)
+
+inline Scalar ScalarFromDouble(double value)
+{
+	return value;
+}
+
+inline double ScalarToDouble(Scalar value)
+{
+	return value;
+}
+
+// Same as the game always did, so the double build keeps playing the same games
+inline Scalar SinDegrees(Scalar degrees)
+{
+	return sin(degrees * 3.14159265 / 180);
+}
+
+inline Scalar CosDegrees(Scalar degrees)
+{
+	return cos(degrees * 3.14159265 / 180);
+}
+
+inline Scalar SquareRoot(Scalar value)
+{
+	return sqrt(value);
+}
+
+#endif
+
+// Name of the physics number type, for tools to print
+inline const char* GetScalarName()
+{
+#ifdef ASTEROIDS_FIXED_POINT
+	return "fixed16";
+#else
+	return "double";
+#endif
+}
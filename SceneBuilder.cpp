@@ -0,0 +1,128 @@
+#include <math.h>
+#include "World.h"
+#include "Trace.h"
+#include "SceneBuilder.h"
+
+static RenderPoint MakePoint(double x, double y)
+{
+    RenderPoint point;
+    point.x = (float)x;
+    point.y = (float)y;
+    return point;
+}
+
+SceneBuilder::SceneBuilder()
+{
+    // Initializes 3 ships representing lives left
+    for (int i = 0; i < 3; i++)
+    {
+        lifeShips[i] = Ship(i);
+    }
+}
+
+SceneBuilder::~SceneBuilder()
+{
+}
+
+void SceneBuilder::Build(RenderSnapshot* snapshot, double alpha, CommandList* commands)
+{
+    // alpha says how far we are between the last two ticks, positions are interpolated with it
+    TRACE_SCOPE("BuildScene");
+    commands->Clear();
+
+    // All the projectiles
+    ProjectileField* projectiles = &snapshot->projectiles;
+    for (int i = 0; i < projectiles->GetCount(); i++)
+    {
+        if (projectiles->IsAlive(i))
+        {
+            DrawProjectile(projectiles, i, alpha, commands);
+        }
+    }
+
+    if (!snapshot->gameOver || snapshot->gameWon)
+    {
+        // The ship only if it's not game over
+        DrawShip(&snapshot->ship, alpha, commands);
+    }
+
+    // The asteroids
+    AsteroidField* asteroids = &snapshot->asteroids;
+    for (int i = 0; i < asteroids->GetCount(); i++)
+    {
+        DrawAsteroid(asteroids, i, alpha, commands);
+    }
+
+    // What's left of whatever exploded
+    DrawParticles(&snapshot->particles, alpha, commands);
+
+    // The "lives" ships
+    for (int i = 0; i < snapshot->lives && i < 3; i++)
+    {
+        DrawShip(&lifeShips[i], 1, commands);
+    }
+
+    // Game Over: the "Game Over" or "You Win" texts
+    if (snapshot->gameOver)
+    {
+        commands->AddText(BRUSH_WHITE, snapshot->gameWon ? "You Win!" : "Game Over!", MakePoint(0, 0), MakePoint(RESOLUTION_X, RESOLUTION_X));
+    }
+
+    commands->Sort();
+}
+
+void SceneBuilder::DrawShip(Ship* ship, double alpha, CommandList* commands)
+{
+    // Once it exploded, only its debris is left (see DrawParticles)
+    if (ship->IsExploded())
+    {
+        return;
+    }
+
+    // We draw the ship as a triangle
+    Point2D position = ship->GetInterpolatedPosition(alpha);
+    double rotation = ship->GetInterpolatedRotation(alpha);
+
+    // Calculate the head position and the 2 sides based on position and rotation
+    RenderPoint headPoint = MakePoint(position.x + SHIP_NOSE_LENGTH * sin(rotation * PI / 180), position.y - SHIP_NOSE_LENGTH * cos(rotation * PI / 180));
+    RenderPoint leftPoint = MakePoint(position.x + SHIP_WING_LENGTH * sin((rotation - 120) * PI / 180), position.y - SHIP_WING_LENGTH * cos((rotation - 120) * PI / 180));
+    RenderPoint rightPoint = MakePoint(position.x + SHIP_WING_LENGTH * sin((rotation + 120) * PI / 180), position.y - SHIP_WING_LENGTH * cos((rotation + 120) * PI / 180));
+    commands->AddTriangle(BRUSH_GREEN, headPoint, leftPoint, rightPoint);
+}
+
+void SceneBuilder::DrawAsteroid(AsteroidField* asteroids, int index, double alpha, CommandList* commands)
+{
+    Point2D position = asteroids->GetInterpolatedPosition(index, alpha);
+
+    // We draw the asteroid's outline.
+    // It's kept in the asteroid's own space, so we only rotate it and move it into place
+    double rotation = asteroids->GetInterpolatedRotation(index, alpha) * PI / 180;
+    double c = cos(rotation);
+    double s = sin(rotation);
+    const Point2D* outline = asteroids->GetOutline(index);
+
+    RenderPoint points[ASTEROID_CORNERS];
+    for (int i = 0; i < ASTEROID_CORNERS; i++)
+    {
+        points[i] = MakePoint(position.x + outline[i].x * c - outline[i].y * s, position.y + outline[i].x * s + outline[i].y * c);
+    }
+    commands->AddPolyline(BRUSH_BLUE, points, ASTEROID_CORNERS, 4);
+}
+
+void SceneBuilder::DrawParticles(ParticlePool* particles, double alpha, CommandList* commands)
+{
+    // Explosion debris: a dot per particle, orange for the ship and yellow for asteroids.
+    // Sorting puts all the dots of a color together, so they're drawn as one batch
+    for (int i = 0; i < particles->GetCount(); i++)
+    {
+        Point2D position = particles->GetInterpolatedPosition(i, alpha);
+        RenderBrush brush = particles->GetKind(i) == PARTICLE_SHIP ? BRUSH_ORANGE : BRUSH_YELLOW;
+        commands->AddCircle(brush, MakePoint(position.x, position.y), 4);
+    }
+}
+
+void SceneBuilder::DrawProjectile(ProjectileField* projectiles, int index, double alpha, CommandList* commands)
+{
+    Point2D position = projectiles->GetInterpolatedPosition(index, alpha);
+    commands->AddCircle(BRUSH_RED, MakePoint(position.x, position.y), 5);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "RenderSnapshot.h"
+#include "CommandList.h"
+
+// Turns a snapshot of the game into draw commands. It knows what the game looks like, but not how to draw it:
+// that's up to the backend the commands go to (Direct2D in the game, the null or recording backends in tools)
+class SceneBuilder
+{
+public:
+	SceneBuilder();
+	~SceneBuilder();
+
+	// Clears the list, adds everything to draw, between the snapshot's tick and the next one, and sorts it
+	void Build(RenderSnapshot* snapshot, double alpha, CommandList* commands);
+
+private:
+	void DrawShip(Ship* ship, double alpha, CommandList* commands);
+	void DrawAsteroid(AsteroidField* asteroids, int index, double alpha, CommandList* commands);
+	void DrawProjectile(ProjectileField* projectiles, int index, double alpha, CommandList* commands);
+	void DrawParticles(ParticlePool* particles, double alpha, CommandList* commands);
+
+	// These ships are purely for drawing the lives left on the screen, we don't actually control them or check for collisions
+	Ship lifeShips[3];
+};
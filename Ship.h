@@ -1,7 +1,16 @@
 #pragma once
 
-#include "resource.h"
 #include "Point2D.h"
+#include "Scalar.h"
+#include "StateBuffer.h"
+
+// The ship is a triangle: the nose is this far ahead of the center, and the two back corners this far away, 120 degrees to each side
+#define SHIP_NOSE_LENGTH 30
+#define SHIP_WING_LENGTH 15
+// Bounding circle of the ship, around the whole triangle
+#define SHIP_RADIUS SHIP_NOSE_LENGTH
+// Seconds between the ship exploding and the next life
+#define SHIP_RESPAWN_TIME 0.5
 
 class Ship
 {
@@ -10,30 +19,42 @@ public:
 	Ship(int lifeNo);
 	~Ship();
 
-	void InitializeD2D(ID2D1HwndRenderTarget* m_pRenderTarget);
-	void Advance(double elapsedTime);
-	void ApplyLeftRotation(double elapsedTime);
-	void ApplyRightRotation(double elapsedTime);
-	void ApplyAcceleration(double elapsedTime);
+	void Advance(Scalar elapsedTime);
+	void ApplyLeftRotation(Scalar elapsedTime);
+	void ApplyRightRotation(Scalar elapsedTime);
+	void ApplyAcceleration(Scalar elapsedTime);
 	void Explode();
 	void Reset();
-
-	void Draw(ID2D1HwndRenderTarget* m_pRenderTarget);
+	// Remembers where the ship is at the start of a tick, so drawing can interpolate between ticks
+	void StorePreviousState();
+	void SaveState(StateWriter& writer);
+	void LoadState(StateReader& reader);
 
 	Point2D GetPosition();
+	// Where the ship was at the start of the tick, moved along if it wrapped around the screen
+	Point2D GetPreviousPosition();
+	// Corners of the ship's triangle at a time in the last tick, from 0 at its start to 1 (where it is now): nose, left, right.
+	// In between, the ship is moved and turned in a straight line from where it was
+	void GetTriangle(Scalar time, Scalar* cornersX, Scalar* cornersY);
 	double GetRotation();
+	// Rotation at the start of the tick
+	double GetPreviousRotation();
+	Point2D GetInterpolatedPosition(double alpha);
+	double GetInterpolatedRotation(double alpha);
 	bool IsExploded();
-	double GetExplosionTime();
 
 private:
-	Point2D position;
-	Point2D speed;
+	// Physics numbers (see Scalar.h). The getters hand them out as doubles
+	Scalar x;
+	Scalar y;
+	Scalar speedX;
+	Scalar speedY;
 
-	double rotation;
+	Scalar rotation;
 	bool exploded;
-	double explosionTime;
 
-	ID2D1SolidColorBrush* m_pGreenBrush;
-	ID2D1SolidColorBrush* m_pYellowBrush;
+	Scalar previousX;
+	Scalar previousY;
+	Scalar previousRotation;
 };
 
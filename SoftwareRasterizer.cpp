@@ -0,0 +1,296 @@
+#include <math.h>
+#include <string.h>
+#include "Trace.h"
+#include "SoftwareRasterizer.h"
+
+// The same colors the Direct2D renderer uses (D2D1::ColorF names)
+static const uint32_t BRUSH_COLORS[BRUSH_COUNT] =
+{
+	0xFFFFFF, // White
+	0x008000, // Green
+	0xFFA500, // Orange
+	0x0000FF, // Blue
+	0xFFFF00, // Yellow
+	0xFF0000, // Red
+};
+
+// Classic 5x7 font, printable ASCII from ' ' to '~'. One byte per column, bit 0 is the top row, bit 7 goes below the baseline
+static const unsigned char FONT_GLYPHS[95][5] =
+{
+	{ 0x00, 0x00, 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x5F, 0x00, 0x00 }, { 0x00, 0x07, 0x00, 0x07, 0x00 }, { 0x14, 0x7F, 0x14, 0x7F, 0x14 },
+	{ 0x24, 0x2A, 0x7F, 0x2A, 0x12 }, { 0x23, 0x13, 0x08, 0x64, 0x62 }, { 0x36, 0x49, 0x56, 0x20, 0x50 }, { 0x00, 0x08, 0x07, 0x03, 0x00 },
+	{ 0x00, 0x1C, 0x22, 0x41, 0x00 }, { 0x00, 0x41, 0x22, 0x1C, 0x00 }, { 0x2A, 0x1C, 0x7F, 0x1C, 0x2A }, { 0x08, 0x08, 0x3E, 0x08, 0x08 },
+	{ 0x00, 0x80, 0x70, 0x30, 0x00 }, { 0x08, 0x08, 0x08, 0x08, 0x08 }, { 0x00, 0x00, 0x60, 0x60, 0x00 }, { 0x20, 0x10, 0x08, 0x04, 0x02 },
+	{ 0x3E, 0x51, 0x49, 0x45, 0x3E }, { 0x00, 0x42, 0x7F, 0x40, 0x00 }, { 0x72, 0x49, 0x49, 0x49, 0x46 }, { 0x21, 0x41, 0x49, 0x4D, 0x33 },
+	{ 0x18, 0x14, 0x12, 0x7F, 0x10 }, { 0x27, 0x45, 0x45, 0x45, 0x39 }, { 0x3C, 0x4A, 0x49, 0x49, 0x31 }, { 0x41, 0x21, 0x11, 0x09, 0x07 },
+	{ 0x36, 0x49, 0x49, 0x49, 0x36 }, { 0x46, 0x49, 0x49, 0x29, 0x1E }, { 0x00, 0x00, 0x14, 0x00, 0x00 }, { 0x00, 0x40, 0x34, 0x00, 0x00 },
+	{ 0x00, 0x08, 0x14, 0x22, 0x41 }, { 0x14, 0x14, 0x14, 0x14, 0x14 }, { 0x00, 0x41, 0x22, 0x14, 0x08 }, { 0x02, 0x01, 0x59, 0x09, 0x06 },
+	{ 0x3E, 0x41, 0x5D, 0x59, 0x4E }, { 0x7C, 0x12, 0x11, 0x12, 0x7C }, { 0x7F, 0x49, 0x49, 0x49, 0x36 }, { 0x3E, 0x41, 0x41, 0x41, 0x22 },
+	{ 0x7F, 0x41, 0x41, 0x41, 0x3E }, { 0x7F, 0x49, 0x49, 0x49, 0x41 }, { 0x7F, 0x09, 0x09, 0x09, 0x01 }, { 0x3E, 0x41, 0x41, 0x51, 0x73 },
+	{ 0x7F, 0x08, 0x08, 0x08, 0x7F }, { 0x00, 0x41, 0x7F, 0x41, 0x00 }, { 0x20, 0x40, 0x41, 0x3F, 0x01 }, { 0x7F, 0x08, 0x14, 0x22, 0x41 },
+	{ 0x7F, 0x40, 0x40, 0x40, 0x40 }, { 0x7F, 0x02, 0x1C, 0x02, 0x7F }, { 0x7F, 0x04, 0x08, 0x10, 0x7F }, { 0x3E, 0x41, 0x41, 0x41, 0x3E },
+	{ 0x7F, 0x09, 0x09, 0x09, 0x06 }, { 0x3E, 0x41, 0x51, 0x21, 0x5E }, { 0x7F, 0x09, 0x19, 0x29, 0x46 }, { 0x26, 0x49, 0x49, 0x49, 0x32 },
+	{ 0x03, 0x01, 0x7F, 0x01, 0x03 }, { 0x3F, 0x40, 0x40, 0x40, 0x3F }, { 0x1F, 0x20, 0x40, 0x20, 0x1F }, { 0x3F, 0x40, 0x38, 0x40, 0x3F },
+	{ 0x63, 0x14, 0x08, 0x14, 0x63 }, { 0x03, 0x04, 0x78, 0x04, 0x03 }, { 0x61, 0x59, 0x49, 0x4D, 0x43 }, { 0x00, 0x7F, 0x41, 0x41, 0x41 },
+	{ 0x02, 0x04, 0x08, 0x10, 0x20 }, { 0x00, 0x41, 0x41, 0x41, 0x7F }, { 0x04, 0x02, 0x01, 0x02, 0x04 }, { 0x40, 0x40, 0x40, 0x40, 0x40 },
+	{ 0x00, 0x03, 0x07, 0x08, 0x00 }, { 0x20, 0x54, 0x54, 0x78, 0x40 }, { 0x7F, 0x28, 0x44, 0x44, 0x38 }, { 0x38, 0x44, 0x44, 0x44, 0x28 },
+	{ 0x38, 0x44, 0x44, 0x28, 0x7F }, { 0x38, 0x54, 0x54, 0x54, 0x18 }, { 0x00, 0x08, 0x7E, 0x09, 0x02 }, { 0x18, 0xA4, 0xA4, 0x9C, 0x78 },
+	{ 0x7F, 0x08, 0x04, 0x04, 0x78 }, { 0x00, 0x44, 0x7D, 0x40, 0x00 }, { 0x20, 0x40, 0x40, 0x3D, 0x00 }, { 0x7F, 0x10, 0x28, 0x44, 0x00 },
+	{ 0x00, 0x41, 0x7F, 0x40, 0x00 }, { 0x7C, 0x04, 0x78, 0x04, 0x78 }, { 0x7C, 0x08, 0x04, 0x04, 0x78 }, { 0x38, 0x44, 0x44, 0x44, 0x38 },
+	{ 0xFC, 0x18, 0x24, 0x24, 0x18 }, { 0x18, 0x24, 0x24, 0x18, 0xFC }, { 0x7C, 0x08, 0x04, 0x04, 0x08 }, { 0x48, 0x54, 0x54, 0x54, 0x24 },
+	{ 0x04, 0x04, 0x3F, 0x44, 0x24 }, { 0x3C, 0x40, 0x40, 0x20, 0x7C }, { 0x1C, 0x20, 0x40, 0x20, 0x1C }, { 0x3C, 0x40, 0x30, 0x40, 0x3C },
+	{ 0x44, 0x28, 0x10, 0x28, 0x44 }, { 0x4C, 0x90, 0x90, 0x90, 0x7C }, { 0x44, 0x64, 0x54, 0x4C, 0x44 }, { 0x00, 0x08, 0x36, 0x41, 0x00 },
+	{ 0x00, 0x00, 0x77, 0x00, 0x00 }, { 0x00, 0x41, 0x36, 0x08, 0x00 }, { 0x02, 0x01, 0x02, 0x04, 0x02 },
+};
+
+#define FONT_FIRST_CHAR ' '
+#define FONT_COLUMNS 5
+// Rows above the baseline
+#define FONT_ROWS 7
+// Each glyph is scaled up this much, to come close to the 60 pixel Verdana the game uses
+#define FONT_SCALE 7
+
+static float Clamp01(float value)
+{
+	return value < 0 ? 0 : (value > 1 ? 1 : value);
+}
+
+SoftwareRasterizer::SoftwareRasterizer(int width, int height) : width(width), height(height), pixels((size_t)width * height)
+{
+}
+
+int SoftwareRasterizer::GetWidth()
+{
+	return width;
+}
+
+int SoftwareRasterizer::GetHeight()
+{
+	return height;
+}
+
+const uint32_t* SoftwareRasterizer::GetPixels()
+{
+	return pixels.data();
+}
+
+void SoftwareRasterizer::Submit(CommandList* commands)
+{
+	TRACE_SCOPE("Rasterize");
+	memset(pixels.data(), 0, pixels.size() * sizeof(uint32_t));
+
+	for (int i = 0; i < commands->GetCount(); i++)
+	{
+		const RenderCommand& command = commands->GetCommand(i);
+		const RenderPoint* points = commands->GetPoints(command);
+		uint32_t color = BRUSH_COLORS[command.brush];
+		switch (command.primitive)
+		{
+		case PRIMITIVE_POLYLINE:
+			DrawPolyline(points, command.pointCount, command.size, color);
+			break;
+		case PRIMITIVE_TRIANGLE:
+			DrawTriangle(points, color);
+			break;
+		case PRIMITIVE_CIRCLE:
+			DrawCircle(points[0], command.size, color);
+			break;
+		case PRIMITIVE_TEXT:
+			DrawString(command.text, points[0], points[1], color);
+			break;
+		}
+	}
+}
+
+bool SoftwareRasterizer::ClipBox(float minX, float minY, float maxX, float maxY, int& left, int& top, int& right, int& bottom)
+{
+	// One more pixel on each side for the antialiased edge
+	left = (int)floorf(minX) - 1;
+	top = (int)floorf(minY) - 1;
+	right = (int)ceilf(maxX) + 1;
+	bottom = (int)ceilf(maxY) + 1;
+	left = left < 0 ? 0 : left;
+	top = top < 0 ? 0 : top;
+	right = right > width ? width : right;
+	bottom = bottom > height ? height : bottom;
+	return left < right && top < bottom;
+}
+
+void SoftwareRasterizer::Blend(int x, int y, uint32_t color, float coverage)
+{
+	if (coverage <= 0)
+	{
+		return;
+	}
+
+	uint32_t& pixel = pixels[(size_t)y * width + x];
+	if (coverage >= 1)
+	{
+		pixel = color;
+		return;
+	}
+
+	int weight = (int)(coverage * 256);
+	uint32_t result = 0;
+	for (int shift = 0; shift < 24; shift += 8)
+	{
+		int from = (pixel >> shift) & 0xFF;
+		int to = (color >> shift) & 0xFF;
+		result |= (uint32_t)(from + (((to - from) * weight) >> 8)) << shift;
+	}
+	pixel = result;
+}
+
+void SoftwareRasterizer::DrawPolyline(const RenderPoint* points, int count, float lineWidth, uint32_t color)
+{
+	// Every pixel is covered by how close it is to the nearest segment, so the joints don't get drawn twice
+	float halfWidth = lineWidth / 2;
+	float minX = points[0].x, minY = points[0].y, maxX = points[0].x, maxY = points[0].y;
+	for (int i = 1; i < count; i++)
+	{
+		minX = fminf(minX, points[i].x);
+		minY = fminf(minY, points[i].y);
+		maxX = fmaxf(maxX, points[i].x);
+		maxY = fmaxf(maxY, points[i].y);
+	}
+
+	int left, top, right, bottom;
+	if (!ClipBox(minX - halfWidth, minY - halfWidth, maxX + halfWidth, maxY + halfWidth, left, top, right, bottom))
+	{
+		return;
+	}
+
+	for (int y = top; y < bottom; y++)
+	{
+		float py = y + 0.5f;
+		for (int x = left; x < right; x++)
+		{
+			float px = x + 0.5f;
+			float nearest = 1e30f;
+			for (int i = 0; i < count; i++)
+			{
+				// The outline is closed: the last point joins the first
+				RenderPoint a = points[i];
+				RenderPoint b = points[i + 1 < count ? i + 1 : 0];
+				float dx = b.x - a.x;
+				float dy = b.y - a.y;
+				float length = dx * dx + dy * dy;
+				float t = length > 0 ? ((px - a.x) * dx + (py - a.y) * dy) / length : 0;
+				t = Clamp01(t);
+				float ex = a.x + t * dx - px;
+				float ey = a.y + t * dy - py;
+				nearest = fminf(nearest, ex * ex + ey * ey);
+			}
+			Blend(x, y, color, Clamp01(halfWidth + 0.5f - sqrtf(nearest)));
+		}
+	}
+}
+
+void SoftwareRasterizer::DrawTriangle(const RenderPoint* points, uint32_t color)
+{
+	// Each edge as a line equation, normalized so it gives the distance to the edge, positive inside
+	float area = (points[1].x - points[0].x) * (points[2].y - points[0].y) - (points[1].y - points[0].y) * (points[2].x - points[0].x);
+	if (area == 0)
+	{
+		return;
+	}
+
+	float edgeA[3], edgeB[3], edgeC[3];
+	for (int i = 0; i < 3; i++)
+	{
+		RenderPoint from = points[i];
+		RenderPoint to = points[(i + 1) % 3];
+		float a = from.y - to.y;
+		float b = to.x - from.x;
+		float length = sqrtf(a * a + b * b);
+		float sign = area > 0 ? 1.0f : -1.0f;
+		edgeA[i] = sign * a / length;
+		edgeB[i] = sign * b / length;
+		edgeC[i] = -(edgeA[i] * from.x + edgeB[i] * from.y);
+	}
+
+	float minX = fminf(points[0].x, fminf(points[1].x, points[2].x));
+	float minY = fminf(points[0].y, fminf(points[1].y, points[2].y));
+	float maxX = fmaxf(points[0].x, fmaxf(points[1].x, points[2].x));
+	float maxY = fmaxf(points[0].y, fmaxf(points[1].y, points[2].y));
+	int left, top, right, bottom;
+	if (!ClipBox(minX, minY, maxX, maxY, left, top, right, bottom))
+	{
+		return;
+	}
+
+	for (int y = top; y < bottom; y++)
+	{
+		float py = y + 0.5f;
+		for (int x = left; x < right; x++)
+		{
+			float px = x + 0.5f;
+			float inside = 1e30f;
+			for (int i = 0; i < 3; i++)
+			{
+				inside = fminf(inside, edgeA[i] * px + edgeB[i] * py + edgeC[i]);
+			}
+			Blend(x, y, color, Clamp01(inside + 0.5f));
+		}
+	}
+}
+
+void SoftwareRasterizer::DrawCircle(RenderPoint center, float radius, uint32_t color)
+{
+	int left, top, right, bottom;
+	if (!ClipBox(center.x - radius, center.y - radius, center.x + radius, center.y + radius, left, top, right, bottom))
+	{
+		return;
+	}
+
+	for (int y = top; y < bottom; y++)
+	{
+		float dy = y + 0.5f - center.y;
+		for (int x = left; x < right; x++)
+		{
+			float dx = x + 0.5f - center.x;
+			Blend(x, y, color, Clamp01(radius + 0.5f - sqrtf(dx * dx + dy * dy)));
+		}
+	}
+}
+
+void SoftwareRasterizer::DrawString(const char* text, RenderPoint topLeft, RenderPoint bottomRight, uint32_t color)
+{
+	// Centered in the rectangle, like the game's text format. One blank column between letters
+	int length = (int)strlen(text);
+	int textWidth = (length * (FONT_COLUMNS + 1) - 1) * FONT_SCALE;
+	int textHeight = FONT_ROWS * FONT_SCALE;
+	int originX = (int)((topLeft.x + bottomRight.x - textWidth) / 2);
+	int originY = (int)((topLeft.y + bottomRight.y - textHeight) / 2);
+
+	for (int c = 0; c < length; c++)
+	{
+		int glyph = (unsigned char)text[c] - FONT_FIRST_CHAR;
+		if (glyph < 0 || glyph >= 95)
+		{
+			continue;
+		}
+
+		for (int column = 0; column < FONT_COLUMNS; column++)
+		{
+			unsigned char bits = FONT_GLYPHS[glyph][column];
+			for (int row = 0; row < 8; row++)
+			{
+				if ((bits & (1 << row)) == 0)
+				{
+					continue;
+				}
+
+				int x0 = originX + (c * (FONT_COLUMNS + 1) + column) * FONT_SCALE;
+				int y0 = originY + row * FONT_SCALE;
+				for (int y = y0 < 0 ? 0 : y0; y < y0 + FONT_SCALE && y < height; y++)
+				{
+					for (int x = x0 < 0 ? 0 : x0; x < x0 + FONT_SCALE && x < width; x++)
+					{
+						pixels[(size_t)y * width + x] = color;
+					}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "RenderBackend.h"
+
+// Draws the command list into a framebuffer in memory, on the CPU, with antialiased edges.
+// Looks close to what Direct2D draws, and needs no display or GPU, so frames can be made on any server
+class SoftwareRasterizer : public RenderBackend
+{
+public:
+	SoftwareRasterizer(int width, int height);
+
+	// Clears the frame to black and draws the commands into it
+	void Submit(CommandList* commands) override;
+
+	int GetWidth();
+	int GetHeight();
+	// One pixel per uint32_t, 0x00RRGGBB, rows from top to bottom
+	const uint32_t* GetPixels();
+
+private:
+	void DrawPolyline(const RenderPoint* points, int count, float width, uint32_t color);
+	void DrawTriangle(const RenderPoint* points, uint32_t color);
+	void DrawCircle(RenderPoint center, float radius, uint32_t color);
+	void DrawString(const char* text, RenderPoint topLeft, RenderPoint bottomRight, uint32_t color);
+
+	// Clips the box around a shape to the frame. Returns false if nothing of it is visible
+	bool ClipBox(float minX, float minY, float maxX, float maxY, int& left, int& top, int& right, int& bottom);
+	// Mixes color into the pixel, coverage goes from 0 (untouched) to 1 (replaced)
+	void Blend(int x, int y, uint32_t color, float coverage);
+
+	int width;
+	int height;
+	std::vector<uint32_t> pixels;
+};
@@ -0,0 +1,111 @@
+#include <math.h>
+#include <algorithm>
+#include "SpatialGrid.h"
+
+SpatialGrid::SpatialGrid(double cellSize, double width, double height, double originX, double originY) :
+    cellSize(cellSize), originX(originX), originY(originY)
+{
+    // Whatever doesn't divide evenly wraps onto the first row and column, which only adds a few extra candidates
+    columns = (int)(width / cellSize);
+    rows = (int)(height / cellSize);
+    if (columns < 1)
+        columns = 1;
+    if (rows < 1)
+        rows = 1;
+    cells.resize(columns * rows);
+}
+
+SpatialGrid::~SpatialGrid()
+{
+}
+
+void SpatialGrid::Clear()
+{
+    // Only the cells that got something need clearing, most of the grid is usually empty
+    for (size_t i = 0; i < usedCells.size(); i++)
+    {
+        cells[usedCells[i]].clear();
+    }
+    usedCells.clear();
+}
+
+int SpatialGrid::CellX(double x)
+{
+    // Wraps the cell coordinate, so the grid behaves like a torus
+    int cell = (int)floor((x - originX) / cellSize) % columns;
+    return cell < 0 ? cell + columns : cell;
+}
+
+int SpatialGrid::CellY(double y)
+{
+    int cell = (int)floor((y - originY) / cellSize) % rows;
+    return cell < 0 ? cell + rows : cell;
+}
+
+int SpatialGrid::CellSpan(double extent, int cellCount)
+{
+    // Number of cells a box of this size can touch, never more than the whole row or column.
+    // A box wider than the grid wraps both its ends into the middle of it, so the walks only stop at the end cell
+    // when the span is less than the whole row or column: otherwise they'd stop partway and skip cells
+    int span = (int)(extent / cellSize) + 2;
+    return span < cellCount ? span : cellCount;
+}
+
+void SpatialGrid::Insert(int id, Point2D position, double radius)
+{
+    int startX = CellX(position.x - radius);
+    int startY = CellY(position.y - radius);
+    int endX = CellX(position.x + radius);
+    int endY = CellY(position.y + radius);
+    int spanX = CellSpan(2 * radius, columns);
+    int spanY = CellSpan(2 * radius, rows);
+
+    for (int j = 0, y = startY; j < spanY; j++, y = (y + 1) % rows)
+    {
+        for (int i = 0, x = startX; i < spanX; i++, x = (x + 1) % columns)
+        {
+            std::vector<int>& cell = cells[y * columns + x];
+            if (cell.empty())
+                usedCells.push_back(y * columns + x);
+            cell.push_back(id);
+            if (x == endX && spanX < columns)
+                break;
+        }
+        if (y == endY && spanY < rows)
+            break;
+    }
+}
+
+void SpatialGrid::Query(Point2D position, double radius, std::vector<int>& result)
+{
+    result.clear();
+    int visited = 0;
+
+    int startX = CellX(position.x - radius);
+    int startY = CellY(position.y - radius);
+    int endX = CellX(position.x + radius);
+    int endY = CellY(position.y + radius);
+    int spanX = CellSpan(2 * radius, columns);
+    int spanY = CellSpan(2 * radius, rows);
+
+    for (int j = 0, y = startY; j < spanY; j++, y = (y + 1) % rows)
+    {
+        for (int i = 0, x = startX; i < spanX; i++, x = (x + 1) % columns)
+        {
+            std::vector<int>& cell = cells[y * columns + x];
+            result.insert(result.end(), cell.begin(), cell.end());
+            visited++;
+            if (x == endX && spanX < columns)
+                break;
+        }
+        if (y == endY && spanY < rows)
+            break;
+    }
+
+    // The same id can be in several cells. Sorting also gives callers a deterministic order.
+    // A single cell is already sorted, because ids are inserted in increasing order
+    if (visited == 1)
+        return;
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+}
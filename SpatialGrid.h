@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+#include "Point2D.h"
+
+// Uniform grid used as a collision broadphase, rebuilt every tick.
+// Cell coordinates wrap around the play area the same way the entities do,
+// so a position slightly outside the screen still lands in a valid cell
+class SpatialGrid
+{
+public:
+	SpatialGrid(double cellSize, double width, double height, double originX, double originY);
+	~SpatialGrid();
+
+	void Clear();
+	// Adds the id to every cell touched by the box around the circle. Ids are expected in increasing order
+	void Insert(int id, Point2D position, double radius);
+	// Fills result with the ids found in the cells touched by the box around the circle, sorted and without duplicates
+	void Query(Point2D position, double radius, std::vector<int>& result);
+
+private:
+	int CellX(double x);
+	int CellY(double y);
+	int CellSpan(double extent, int cellCount);
+
+	double cellSize;
+	double originX;
+	double originY;
+	int columns;
+	int rows;
+
+	// One id list per cell. Lists are cleared, not freed, so rebuilding doesn't allocate once the grid is warm
+	std::vector<std::vector<int> > cells;
+	std::vector<int> usedCells;
+};
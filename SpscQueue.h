@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+
+// Fixed-size ring buffer between exactly one producer thread and one consumer thread, without locks.
+// Each side only writes its own index and reads the other's, so pushing and popping never wait.
+// Capacity must be a power of two
+template<typename T, size_t Capacity>
+class SpscQueue
+{
+	static_assert((Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+public:
+	SpscQueue() : head(0), tail(0)
+	{
+	}
+
+	// Producer side. Returns false, and drops the item, if the queue is full
+	bool TryPush(const T& item)
+	{
+		size_t currentTail = tail.load(std::memory_order_relaxed);
+		if (currentTail - head.load(std::memory_order_acquire) == Capacity)
+		{
+			return false;
+		}
+		items[currentTail & (Capacity - 1)] = item;
+		tail.store(currentTail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer side. The oldest item, or NULL if the queue is empty. It stays valid until Pop
+	const T* Front()
+	{
+		size_t currentHead = head.load(std::memory_order_relaxed);
+		if (currentHead == tail.load(std::memory_order_acquire))
+		{
+			return NULL;
+		}
+		return &items[currentHead & (Capacity - 1)];
+	}
+
+	// Consumer side. Removes the item Front returned
+	void Pop()
+	{
+		head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+private:
+	T items[Capacity];
+	// Next item to pop, only written by the consumer
+	alignas(64) std::atomic<size_t> head;
+	// Next free slot, only written by the producer
+	alignas(64) std::atomic<size_t> tail;
+};
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <string.h>
+#include <stddef.h>
+#include <type_traits>
+
+// Writes plain data one after the other into a flat buffer.
+// With a NULL buffer nothing is written and only the size is counted, so the same code measures and saves
+class StateWriter
+{
+public:
+	StateWriter(void* buffer) : buffer((unsigned char*)buffer), size(0)
+	{
+	}
+
+	template<typename T>
+	void Write(const T& value)
+	{
+		WriteArray(&value, 1);
+	}
+
+	template<typename T>
+	void WriteArray(const T* data, size_t count)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Only plain data can go into a state buffer");
+		if (buffer != NULL && count > 0)
+		{
+			memcpy(buffer + size, data, count * sizeof(T));
+		}
+		size += count * sizeof(T);
+	}
+
+	size_t GetSize()
+	{
+		return size;
+	}
+
+private:
+	unsigned char* buffer;
+	size_t size;
+};
+
+// Reads back what a StateWriter wrote. Reading past the end fails the reader instead of overrunning the buffer
+class StateReader
+{
+public:
+	StateReader(const void* buffer, size_t size) : buffer((const unsigned char*)buffer), size(size), position(0), failed(false)
+	{
+	}
+
+	template<typename T>
+	void Read(T& value)
+	{
+		ReadArray(&value, 1);
+	}
+
+	template<typename T>
+	void ReadArray(T* data, size_t count)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Only plain data can come from a state buffer");
+		if (failed || count * sizeof(T) > size - position)
+		{
+			failed = true;
+			return;
+		}
+		if (count > 0)
+		{
+			memcpy(data, buffer + position, count * sizeof(T));
+		}
+		position += count * sizeof(T);
+	}
+
+	void Fail()
+	{
+		failed = true;
+	}
+
+	bool IsValid()
+	{
+		return !failed;
+	}
+
+	// Bytes not read yet
+	size_t GetRemaining()
+	{
+		return size - position;
+	}
+
+private:
+	const unsigned char* buffer;
+	size_t size;
+	size_t position;
+	bool failed;
+};
@@ -0,0 +1,140 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(int threadCount) : batch(0), stopping(false), currentTask(NULL), remaining(0)
+{
+    if (threadCount <= 0)
+    {
+        threadCount = (int)std::thread::hardware_concurrency();
+        if (threadCount <= 0)
+            threadCount = 1;
+    }
+
+    // The calling thread is one of the threads, so we start one less
+    for (int i = 0; i < threadCount; i++)
+    {
+        queues.push_back(new WorkQueue());
+    }
+    for (int i = 1; i < threadCount; i++)
+    {
+        threads.push_back(std::thread(&ThreadPool::WorkerLoop, this, i));
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+    for (size_t i = 0; i < threads.size(); i++)
+    {
+        threads[i].join();
+    }
+    for (size_t i = 0; i < queues.size(); i++)
+    {
+        delete queues[i];
+    }
+}
+
+int ThreadPool::GetThreadCount()
+{
+    return (int)queues.size();
+}
+
+void ThreadPool::ParallelFor(int count, const std::function<void(int)>& task)
+{
+    if (count <= 0)
+        return;
+
+    // The task is set before anything is queued: a worker still leaving the previous batch may already pick up the new tasks
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        currentTask = &task;
+        remaining = count;
+    }
+
+    // Deals the tasks out round-robin; stealing evens out whatever this gets wrong
+    int queueCount = (int)queues.size();
+    for (int i = 0; i < count; i++)
+    {
+        WorkQueue* queue = queues[i % queueCount];
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        queue->tasks.push_back(i);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        batch++;
+    }
+    wakeCondition.notify_all();
+
+    // The calling thread works on queue 0
+    RunTasks(0);
+
+    std::unique_lock<std::mutex> lock(stateMutex);
+    doneCondition.wait(lock, [this] { return remaining == 0; });
+    currentTask = NULL;
+}
+
+void ThreadPool::WorkerLoop(int self)
+{
+    unsigned long long seenBatch = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(stateMutex);
+            wakeCondition.wait(lock, [this, seenBatch] { return stopping || batch != seenBatch; });
+            if (stopping)
+                return;
+            seenBatch = batch;
+        }
+        RunTasks(self);
+    }
+}
+
+void ThreadPool::RunTasks(int self)
+{
+    int queueCount = (int)queues.size();
+    int task;
+    while (true)
+    {
+        // Newest task from our own queue first, it's the most likely to still be in cache
+        bool found = PopTask(self, false, task);
+        for (int i = 1; !found && i < queueCount; i++)
+        {
+            found = PopTask((self + i) % queueCount, true, task);
+        }
+        if (!found)
+            return;
+
+        (*currentTask)(task);
+
+        if (--remaining == 0)
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            doneCondition.notify_all();
+        }
+    }
+}
+
+bool ThreadPool::PopTask(int queue, bool steal, int& task)
+{
+    WorkQueue* workQueue = queues[queue];
+    std::lock_guard<std::mutex> lock(workQueue->mutex);
+    if (workQueue->tasks.empty())
+        return false;
+
+    // Thieves take the oldest task from the front, the owner the newest from the back
+    if (steal)
+    {
+        task = workQueue->tasks.front();
+        workQueue->tasks.pop_front();
+    }
+    else
+    {
+        task = workQueue->tasks.back();
+        workQueue->tasks.pop_back();
+    }
+    return true;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+// Fixed set of worker threads that run batches of independent tasks.
+// Every worker has its own queue; when it runs dry it steals from the front of the others,
+// so uneven tasks still keep all cores busy
+class ThreadPool
+{
+public:
+	// threadCount 0 means one thread per core
+	ThreadPool(int threadCount);
+	~ThreadPool();
+
+	int GetThreadCount();
+
+	// Runs task(i) for every i in [0, count) across all the threads, and returns when they are all done.
+	// The calling thread helps too
+	void ParallelFor(int count, const std::function<void(int)>& task);
+
+private:
+	struct WorkQueue
+	{
+		std::mutex mutex;
+		std::deque<int> tasks;
+	};
+
+	void WorkerLoop(int self);
+	// Runs tasks from our own queue, then from the others, until there is nothing left anywhere
+	void RunTasks(int self);
+	bool PopTask(int queue, bool steal, int& task);
+
+	std::vector<std::thread> threads;
+	// One queue per worker, plus one for the calling thread
+	std::vector<WorkQueue*> queues;
+
+	std::mutex stateMutex;
+	std::condition_variable wakeCondition;
+	std::condition_variable doneCondition;
+	unsigned long long batch;
+	bool stopping;
+
+	const std::function<void(int)>* currentTask;
+	std::atomic<int> remaining;
+};
@@ -0,0 +1,198 @@
+#include "TimerWheel.h"
+
+TimerWheel::TimerWheel()
+{
+	Clear(0);
+}
+
+TimerWheel::~TimerWheel()
+{
+}
+
+void TimerWheel::Clear(long long newTick)
+{
+	// The nodes are only forgotten, not freed, so a cleared wheel doesn't allocate again
+	tick = newTick;
+	count = 0;
+	freeNodes = -1;
+	for (int i = (int)nodes.size() - 1; i >= 0; i--)
+	{
+		nodes[i].next = freeNodes;
+		freeNodes = i;
+	}
+	for (int level = 0; level < TIMER_WHEEL_LEVELS; level++)
+	{
+		for (int slot = 0; slot < TIMER_WHEEL_SLOTS; slot++)
+		{
+			slots[level][slot] = -1;
+		}
+	}
+}
+
+void TimerWheel::Insert(int node)
+{
+	long long due = nodes[node].timer.tick;
+	long long delay = due - tick;
+
+	// The lowest level whose slots still cover the delay. Longer delays go in the top level and come round again
+	int level = 0;
+	while (level < TIMER_WHEEL_LEVELS - 1 && delay >= (1LL << (TIMER_WHEEL_SLOT_BITS * (level + 1))))
+	{
+		level++;
+	}
+
+	int slot = (int)((due >> (TIMER_WHEEL_SLOT_BITS * level)) & (TIMER_WHEEL_SLOTS - 1));
+	nodes[node].next = slots[level][slot];
+	slots[level][slot] = node;
+}
+
+void TimerWheel::Schedule(long long due, int type, unsigned int data)
+{
+	int node;
+	if (freeNodes >= 0)
+	{
+		node = freeNodes;
+		freeNodes = nodes[node].next;
+	}
+	else
+	{
+		node = (int)nodes.size();
+		nodes.push_back(Node());
+	}
+
+	nodes[node].timer.tick = due > tick ? due : tick + 1;
+	nodes[node].timer.type = type;
+	nodes[node].timer.data = data;
+	nodes[node].unused = 0;
+	Insert(node);
+	count++;
+}
+
+void TimerWheel::Cascade(int level)
+{
+	// The wheel just reached this slot's block: its timers move down to the levels that now cover them
+	int slot = (int)((tick >> (TIMER_WHEEL_SLOT_BITS * level)) & (TIMER_WHEEL_SLOTS - 1));
+	int node = slots[level][slot];
+	slots[level][slot] = -1;
+	while (node >= 0)
+	{
+		int next = nodes[node].next;
+		Insert(node);
+		node = next;
+	}
+}
+
+void TimerWheel::Advance(std::vector<Timer>& fired)
+{
+	tick++;
+
+	// From the top down, so timers moving down more than one level get all the way
+	for (int level = TIMER_WHEEL_LEVELS - 1; level > 0; level--)
+	{
+		if ((tick & ((1LL << (TIMER_WHEEL_SLOT_BITS * level)) - 1)) == 0)
+		{
+			Cascade(level);
+		}
+	}
+
+	int slot = (int)(tick & (TIMER_WHEEL_SLOTS - 1));
+	int node = slots[0][slot];
+	slots[0][slot] = -1;
+	while (node >= 0)
+	{
+		int next = nodes[node].next;
+		if (nodes[node].timer.tick == tick)
+		{
+			fired.push_back(nodes[node].timer);
+			nodes[node].next = freeNodes;
+			freeNodes = node;
+			count--;
+		}
+		else
+		{
+			// Only a timer from past the top level can be here early: it goes round again
+			Insert(node);
+		}
+		node = next;
+	}
+}
+
+long long TimerWheel::GetTick()
+{
+	return tick;
+}
+
+int TimerWheel::GetCount()
+{
+	return count;
+}
+
+void TimerWheel::SaveState(StateWriter& writer)
+{
+	unsigned int nodeCount = (unsigned int)nodes.size();
+	writer.Write(tick);
+	writer.Write(count);
+	writer.Write(freeNodes);
+	writer.Write(nodeCount);
+	writer.WriteArray(&slots[0][0], TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS);
+	writer.WriteArray(nodes.data(), nodeCount);
+}
+
+void TimerWheel::LoadState(StateReader& reader)
+{
+	unsigned int nodeCount = 0;
+	reader.Read(tick);
+	reader.Read(count);
+	reader.Read(freeNodes);
+	reader.Read(nodeCount);
+	if (!reader.IsValid() || count < 0 || (unsigned int)count > nodeCount || nodeCount > reader.GetRemaining())
+	{
+		reader.Fail();
+		return;
+	}
+
+	// Resizing only allocates if this wheel never held that many timers
+	nodes.resize(nodeCount);
+	reader.ReadArray(&slots[0][0], TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS);
+	reader.ReadArray(nodes.data(), nodeCount);
+
+	// A list pointing outside the nodes would send Advance off into memory
+	bool valid = freeNodes >= -1 && freeNodes < (int)nodeCount;
+	for (int i = 0; i < TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS; i++)
+	{
+		valid = valid && (&slots[0][0])[i] >= -1 && (&slots[0][0])[i] < (int)nodeCount;
+	}
+	for (unsigned int i = 0; i < nodeCount; i++)
+	{
+		valid = valid && nodes[i].next >= -1 && nodes[i].next < (int)nodeCount;
+	}
+
+	// And every node must be in exactly one list, once: a node reached twice means a cycle, which Advance would go round forever,
+	// or two lists sharing a tail. The scheduled ones must also add up to the count
+	nodeSeen.assign(nodeCount, 0);
+	int scheduled = 0;
+	for (int i = 0; valid && i < TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS; i++)
+	{
+		for (int node = (&slots[0][0])[i]; valid && node >= 0; node = nodes[node].next)
+		{
+			valid = !nodeSeen[node];
+			nodeSeen[node] = 1;
+			scheduled++;
+		}
+	}
+	for (int node = freeNodes; valid && node >= 0; node = nodes[node].next)
+	{
+		valid = !nodeSeen[node];
+		nodeSeen[node] = 1;
+	}
+	valid = valid && scheduled == count;
+	for (unsigned int i = 0; valid && i < nodeCount; i++)
+	{
+		valid = nodeSeen[i] != 0;
+	}
+
+	if (!valid)
+	{
+		reader.Fail();
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+#include "StateBuffer.h"
+
+#define TIMER_WHEEL_LEVELS 4
+#define TIMER_WHEEL_SLOT_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_SLOT_BITS)
+
+// Something that happens at a given tick. What type and data mean is up to whoever schedules it
+struct Timer
+{
+	long long tick;
+	int type;
+	unsigned int data;
+};
+
+// Timers keyed on simulation ticks, in a hierarchical timing wheel.
+// Level 0 has a slot for each of the next 64 ticks, level 1 a slot for each of the next 64 blocks of 64 ticks, and so on.
+// A timer goes in the lowest level its delay fits in, and moves down a level each time the wheel reaches its block,
+// so scheduling is O(1), and each tick only looks at the timers due in it, plus the ones moving down (at most 3 moves per timer).
+// Delays past the top level are fine too, those timers just go round the top level again.
+// Timers can't be cancelled: whoever handles one checks it still applies
+class TimerWheel
+{
+public:
+	TimerWheel();
+	~TimerWheel();
+
+	// Drops every timer, the wheel is now at the given tick
+	void Clear(long long tick);
+	// Timers due at the current tick or before go off on the next one
+	void Schedule(long long tick, int type, unsigned int data);
+	// Moves to the next tick and adds the timers due then to fired, always in the same order for the same schedule
+	void Advance(std::vector<Timer>& fired);
+
+	long long GetTick();
+	int GetCount();
+
+	// Timers are saved with the wheel's own bookkeeping, so a loaded wheel goes off exactly like the saved one
+	void SaveState(StateWriter& writer);
+	void LoadState(StateReader& reader);
+
+private:
+	// Timers are nodes in singly linked lists, one list per slot. Free nodes are in a list too
+	struct Node
+	{
+		Timer timer;
+		int next;
+		// Fills what would otherwise be padding, always 0: nodes are saved as raw bytes, and padding would make
+		// two wheels with the same timers save different states
+		int unused;
+	};
+
+	void Insert(int node);
+	void Cascade(int level);
+
+	long long tick;
+	int count;
+	int freeNodes;
+	int slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+	std::vector<Node> nodes;
+	// Scratch for LoadState, kept so loading doesn't allocate again
+	std::vector<char> nodeSeen;
+};
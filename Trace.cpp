@@ -0,0 +1,162 @@
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include "Trace.h"
+
+std::atomic<bool> Trace::enabled(false);
+
+namespace
+{
+    // The fields are atomic so the exporter can copy them while the thread overwrites them.
+    // Relaxed loads and stores of them are plain moves
+    struct TraceEvent
+    {
+        std::atomic<const char*> name;
+        std::atomic<long long> begin;
+        std::atomic<long long> end;
+    };
+
+    // What the exporter copies out of a buffer
+    struct TraceSpan
+    {
+        const char* name;
+        long long begin;
+        long long end;
+    };
+
+    // Only its own thread writes to a buffer. The write count is published after the event,
+    // so the exporter can read it while the thread goes on; the oldest events are overwritten
+    struct ThreadBuffer
+    {
+        int threadId;
+        std::atomic<long long> written;
+        TraceEvent events[Trace::BUFFER_CAPACITY];
+    };
+
+    // Copies the spans still in the buffer, like a seqlock reader: the thread may overwrite the oldest ones while we copy,
+    // so the write count is read again afterwards, and the spans it could have reached are dropped
+    void CopySpans(ThreadBuffer* buffer, std::vector<TraceSpan>& spans)
+    {
+        long long written = buffer->written.load(std::memory_order_acquire);
+        long long first = written > Trace::BUFFER_CAPACITY ? written - Trace::BUFFER_CAPACITY : 0;
+        spans.resize((size_t)(written - first));
+        for (long long i = first; i < written; i++)
+        {
+            const TraceEvent& event = buffer->events[i % Trace::BUFFER_CAPACITY];
+            TraceSpan& span = spans[(size_t)(i - first)];
+            span.name = event.name.load(std::memory_order_relaxed);
+            span.begin = event.begin.load(std::memory_order_relaxed);
+            span.end = event.end.load(std::memory_order_relaxed);
+        }
+
+        // If we read anything the thread wrote for span number n, this sees a count of at least n (see Record).
+        // Writing span n overwrites span n - BUFFER_CAPACITY, so everything up to that one may be torn
+        std::atomic_thread_fence(std::memory_order_acquire);
+        long long writtenAfter = buffer->written.load(std::memory_order_relaxed);
+        long long torn = writtenAfter - Trace::BUFFER_CAPACITY + 1 - first;
+        if (torn > 0)
+        {
+            spans.erase(spans.begin(), spans.begin() + (size_t)std::min(torn, (long long)spans.size()));
+        }
+    }
+
+    // Every buffer ever created. Only touched when a thread records its first span and when exporting.
+    // Buffers are never freed, so spans of finished threads can still be exported
+    std::mutex registryMutex;
+    std::vector<ThreadBuffer*> registry;
+
+    thread_local ThreadBuffer* threadBuffer = NULL;
+
+    ThreadBuffer* GetThreadBuffer()
+    {
+        if (threadBuffer == NULL)
+        {
+            ThreadBuffer* buffer = new ThreadBuffer();
+            buffer->written.store(0, std::memory_order_relaxed);
+
+            std::lock_guard<std::mutex> lock(registryMutex);
+            buffer->threadId = (int)registry.size() + 1;
+            registry.push_back(buffer);
+            threadBuffer = buffer;
+        }
+        return threadBuffer;
+    }
+}
+
+void Trace::SetEnabled(bool newEnabled)
+{
+    enabled.store(newEnabled, std::memory_order_relaxed);
+}
+
+long long Trace::Now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Trace::Record(const char* name, long long begin, long long end)
+{
+    ThreadBuffer* buffer = GetThreadBuffer();
+    long long written = buffer->written.load(std::memory_order_relaxed);
+    TraceEvent& event = buffer->events[written % BUFFER_CAPACITY];
+
+    // Pairs with the fence in CopySpans: an exporter that sees any of these stores also sees the count published before them
+    std::atomic_thread_fence(std::memory_order_release);
+    event.name.store(name, std::memory_order_relaxed);
+    event.begin.store(begin, std::memory_order_relaxed);
+    event.end.store(end, std::memory_order_relaxed);
+    buffer->written.store(written + 1, std::memory_order_release);
+}
+
+bool Trace::ExportChromeJson(const char* path)
+{
+    FILE* file = fopen(path, "w");
+    if (file == NULL)
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+
+    // Every buffer is copied first, the threads keep recording meanwhile
+    std::vector<std::vector<TraceSpan>> spans(registry.size());
+    for (size_t t = 0; t < registry.size(); t++)
+    {
+        CopySpans(registry[t], spans[t]);
+    }
+
+    // Times are written in microseconds from the first span, which is what the viewers expect
+    long long origin = 0;
+    for (size_t t = 0; t < spans.size(); t++)
+    {
+        if (!spans[t].empty())
+        {
+            long long begin = spans[t][0].begin;
+            if (origin == 0 || begin < origin)
+            {
+                origin = begin;
+            }
+        }
+    }
+
+    fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    bool firstEvent = true;
+    for (size_t t = 0; t < registry.size(); t++)
+    {
+        ThreadBuffer* buffer = registry[t];
+        fprintf(file, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": \"Thread %d\"}}",
+            firstEvent ? "" : ",\n", buffer->threadId, buffer->threadId);
+        firstEvent = false;
+
+        for (size_t i = 0; i < spans[t].size(); i++)
+        {
+            const TraceSpan& span = spans[t][i];
+            fprintf(file, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}",
+                span.name, buffer->threadId, (span.begin - origin) / 1000.0, (span.end - span.begin) / 1000.0);
+        }
+    }
+    fprintf(file, "\n]}\n");
+
+    return fclose(file) == 0;
+}
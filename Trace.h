@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+
+// Lightweight timing spans for finding out what made a frame slow.
+// Each thread writes its spans into its own ring buffer, without locks, keeping the most recent ones.
+// ExportChromeJson writes them all out in the Chrome trace format, which chrome://tracing and Perfetto open.
+// Tracing is off until Trace::SetEnabled(true); while it's off a span costs one flag check
+class Trace
+{
+public:
+	static void SetEnabled(bool enabled);
+	static bool IsEnabled()
+	{
+		return enabled.load(std::memory_order_relaxed);
+	}
+
+	// Nanoseconds on a monotonic clock
+	static long long Now();
+
+	// Adds a finished span to the calling thread's buffer. The name must stay valid, string literals are best
+	static void Record(const char* name, long long begin, long long end);
+
+	// Writes the spans of every thread that recorded something
+	static bool ExportChromeJson(const char* path);
+
+	// How many spans each thread keeps
+	static const int BUFFER_CAPACITY = 1 << 16;
+
+private:
+	static std::atomic<bool> enabled;
+};
+
+// Records a span from its construction to the end of the scope
+class TraceScope
+{
+public:
+	TraceScope(const char* name) : name(name), begin(Trace::IsEnabled() ? Trace::Now() : 0)
+	{
+	}
+
+	~TraceScope()
+	{
+		if (begin != 0)
+		{
+			Trace::Record(name, begin, Trace::Now());
+		}
+	}
+
+private:
+	const char* name;
+	long long begin;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+// Times the rest of the enclosing scope. Builds with ASTEROIDS_DISABLE_TRACE compile the scopes out
+#ifndef ASTEROIDS_DISABLE_TRACE
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+#else
+#define TRACE_SCOPE(name) do {} while (0)
+#endif
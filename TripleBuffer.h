@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+
+// Hands the latest version of a value from one writer thread to one reader thread without locks or waiting.
+// There are three copies: the writer fills one, the reader reads another, and the third holds the newest complete one.
+// Publishing and picking up swap a copy with that third one, so neither side ever sees a half-written value,
+// and the reader always gets the most recent one (older ones it didn't pick up in time are simply skipped)
+template<typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer() : middle(1), writeIndex(0), readIndex(2)
+	{
+	}
+
+	// Writer side: the copy to fill in. It's not visible to the reader until Publish
+	T& GetWriteBuffer()
+	{
+		return buffers[writeIndex];
+	}
+
+	void Publish()
+	{
+		int previous = middle.exchange(writeIndex | NEWER, std::memory_order_acq_rel);
+		writeIndex = previous & INDEX;
+	}
+
+	// Reader side: switches to the newest published copy, if there is one. Returns false if nothing new came in
+	bool Update()
+	{
+		if (!(middle.load(std::memory_order_relaxed) & NEWER))
+		{
+			return false;
+		}
+		int previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+		readIndex = previous & INDEX;
+		return true;
+	}
+
+	// The copy being read. It stays the same until the next Update, and the reader must not change it
+	T& GetReadBuffer()
+	{
+		return buffers[readIndex];
+	}
+
+private:
+	static const int INDEX = 3;
+	// Set in the middle index when the writer published something the reader hasn't picked up yet
+	static const int NEWER = 4;
+
+	T buffers[3];
+	alignas(64) std::atomic<int> middle;
+	// Each one only touched by its own side
+	alignas(64) int writeIndex;
+	alignas(64) int readIndex;
+};
@@ -0,0 +1,179 @@
+#include <math.h>
+#include "World.h"
+#include "Engine.h"
+#include "Trace.h"
+#include "VideoExporter.h"
+
+// Frames rasterized at once per thread. More keeps the threads busier, but every frame holds a few MB
+#define FRAMES_PER_THREAD 2
+
+VideoExporter::Frame::Frame() : rasterizer(RESOLUTION_X, RESOLUTION_Y)
+{
+}
+
+VideoExporter::VideoExporter(FILE* file, VideoFormat format, int threadCount, int frameStep) :
+	file(file),
+	format(format),
+	frameStep(frameStep > 0 ? frameStep : 1),
+	tickCount(0),
+	failed(false),
+	frameCount(0),
+	threads(threadCount),
+	pendingFrames(0)
+{
+	frames.resize(threads.GetThreadCount() * FRAMES_PER_THREAD);
+	for (size_t i = 0; i < frames.size(); i++)
+	{
+		frames[i] = new Frame();
+		// RGB takes 3 bytes a pixel. YUV 4:2:0 takes 1 for brightness plus 2 for color shared by 4 pixels
+		size_t pixelCount = (size_t)RESOLUTION_X * RESOLUTION_Y;
+		frames[i]->bytes.resize(format == VIDEO_Y4M ? pixelCount * 3 / 2 : pixelCount * 3);
+	}
+}
+
+VideoExporter::~VideoExporter()
+{
+	for (size_t i = 0; i < frames.size(); i++)
+	{
+		delete frames[i];
+	}
+}
+
+bool VideoExporter::Start(double tickTime)
+{
+	if (format != VIDEO_Y4M)
+	{
+		return true;
+	}
+
+	// Whole frame rates are written as such, others to a thousandth of a frame
+	double framesPerSecond = 1 / (tickTime * frameStep);
+	long long numerator = (long long)floor(framesPerSecond + 0.5);
+	long long denominator = 1;
+	if (fabs(framesPerSecond - numerator) > 1e-6 * framesPerSecond)
+	{
+		numerator = (long long)floor(framesPerSecond * 1000 + 0.5);
+		denominator = 1000;
+	}
+
+	// C420jpeg is full range BT.601, with the chroma sample between the 4 pixels it covers
+	return fprintf(file, "YUV4MPEG2 W%d H%d F%lld:%lld Ip A1:1 C420jpeg\n", RESOLUTION_X, RESOLUTION_Y, numerator, denominator) > 0;
+}
+
+void VideoExporter::OnTick(Engine* engine)
+{
+	tickCount++;
+	if (tickCount < frameStep)
+	{
+		return;
+	}
+	tickCount = 0;
+
+	engine->WriteSnapshot(&frames[pendingFrames]->snapshot);
+	pendingFrames++;
+	if (pendingFrames == (int)frames.size())
+	{
+		FlushBatch();
+	}
+}
+
+bool VideoExporter::Finish()
+{
+	FlushBatch();
+	return !failed && fflush(file) == 0;
+}
+
+long long VideoExporter::GetFrameCount()
+{
+	return frameCount;
+}
+
+void VideoExporter::FlushBatch()
+{
+	TRACE_SCOPE("ExportBatch");
+	threads.ParallelFor(pendingFrames, [this](int i)
+	{
+		RenderFrame(frames[i]);
+	});
+
+	for (int i = 0; i < pendingFrames; i++)
+	{
+		const std::vector<unsigned char>& bytes = frames[i]->bytes;
+		if (format == VIDEO_Y4M && fputs("FRAME\n", file) < 0)
+		{
+			failed = true;
+		}
+		if (fwrite(bytes.data(), 1, bytes.size(), file) != bytes.size())
+		{
+			failed = true;
+		}
+		frameCount++;
+	}
+	pendingFrames = 0;
+}
+
+void VideoExporter::RenderFrame(Frame* frame)
+{
+	// Snapshots are taken right after a tick, so there is nothing to interpolate
+	frame->scene.Build(&frame->snapshot, 1, &frame->commands);
+	frame->rasterizer.Submit(&frame->commands);
+
+	if (format == VIDEO_Y4M)
+		ConvertToYuv(frame->rasterizer.GetPixels(), frame->bytes.data());
+	else
+		ConvertToRgb(frame->rasterizer.GetPixels(), frame->bytes.data());
+}
+
+void VideoExporter::ConvertToRgb(const uint32_t* pixels, unsigned char* bytes)
+{
+	for (int i = 0; i < RESOLUTION_X * RESOLUTION_Y; i++)
+	{
+		bytes[i * 3] = (unsigned char)(pixels[i] >> 16);
+		bytes[i * 3 + 1] = (unsigned char)(pixels[i] >> 8);
+		bytes[i * 3 + 2] = (unsigned char)pixels[i];
+	}
+}
+
+// Pure blue and pure red come out at exactly +128 for U and V, one past what a byte holds around 128
+static inline unsigned char ClampToByte(int value)
+{
+	return (unsigned char)(value < 0 ? 0 : value > 255 ? 255 : value);
+}
+
+void VideoExporter::ConvertToYuv(const uint32_t* pixels, unsigned char* bytes)
+{
+	// Full range BT.601 in 16.16 fixed point. Y for every pixel, then U and V for every 2x2 block
+	unsigned char* planeY = bytes;
+	unsigned char* planeU = planeY + RESOLUTION_X * RESOLUTION_Y;
+	unsigned char* planeV = planeU + (RESOLUTION_X / 2) * (RESOLUTION_Y / 2);
+
+	for (int i = 0; i < RESOLUTION_X * RESOLUTION_Y; i++)
+	{
+		int r = (pixels[i] >> 16) & 0xFF;
+		int g = (pixels[i] >> 8) & 0xFF;
+		int b = pixels[i] & 0xFF;
+		planeY[i] = (unsigned char)((19595 * r + 38470 * g + 7471 * b + 32768) >> 16);
+	}
+
+	for (int y = 0; y < RESOLUTION_Y / 2; y++)
+	{
+		for (int x = 0; x < RESOLUTION_X / 2; x++)
+		{
+			const uint32_t* topLeft = pixels + (y * 2) * RESOLUTION_X + x * 2;
+			uint32_t block[4] = { topLeft[0], topLeft[1], topLeft[RESOLUTION_X], topLeft[RESOLUTION_X + 1] };
+			int r = 0, g = 0, b = 0;
+			for (int i = 0; i < 4; i++)
+			{
+				r += (block[i] >> 16) & 0xFF;
+				g += (block[i] >> 8) & 0xFF;
+				b += block[i] & 0xFF;
+			}
+
+			// Sums of 4 pixels, so the factors are divided by 4 on the way out
+			int u = (-11059 * r - 21709 * g + 32768 * b + (1 << 17)) >> 18;
+			int v = (32768 * r - 27439 * g - 5329 * b + (1 << 17)) >> 18;
+			planeU[y * (RESOLUTION_X / 2) + x] = ClampToByte(u + 128);
+			planeV[y * (RESOLUTION_X / 2) + x] = ClampToByte(v + 128);
+		}
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdio.h>
+#include <vector>
+#include "InputRecording.h"
+#include "SceneBuilder.h"
+#include "SoftwareRasterizer.h"
+#include "ThreadPool.h"
+
+// What the frames are written as
+enum VideoFormat
+{
+	// 8 bits per channel, no header: ffmpeg -f rawvideo -pix_fmt rgb24 -s 800x600 -r 60 -i file
+	VIDEO_RAW_RGB,
+	// YUV4MPEG2 with 4:2:0 chroma, readable by ffmpeg, mpv and most encoders as is
+	VIDEO_Y4M
+};
+
+// Turns a replay into video frames, on the CPU.
+// Attach it as the ReplayListener: every frameStep ticks it takes a snapshot of the game.
+// Snapshots are rasterized a batch at a time on all the threads, then written out in order
+class VideoExporter : public ReplayListener
+{
+public:
+	// threadCount 0 means one thread per core
+	VideoExporter(FILE* file, VideoFormat format, int threadCount, int frameStep);
+	~VideoExporter();
+
+	// Writes the file header. tickTime is the replay's tick length, it sets the frame rate
+	bool Start(double tickTime);
+	void OnTick(Engine* engine) override;
+	// Writes the frames still in the batch. Returns false if anything couldn't be written
+	bool Finish();
+
+	long long GetFrameCount();
+
+	// Turn a rasterized frame (0xRRGGBB per pixel) into the bytes written out for it
+	static void ConvertToRgb(const uint32_t* pixels, unsigned char* bytes);
+	static void ConvertToYuv(const uint32_t* pixels, unsigned char* bytes);
+
+private:
+	// Everything needed to make one frame, owned by one frame of the batch so threads don't share anything
+	struct Frame
+	{
+		Frame();
+
+		RenderSnapshot snapshot;
+		SceneBuilder scene;
+		CommandList commands;
+		SoftwareRasterizer rasterizer;
+		std::vector<unsigned char> bytes;
+	};
+
+	void RenderFrame(Frame* frame);
+	void FlushBatch();
+
+	FILE* file;
+	VideoFormat format;
+	int frameStep;
+	int tickCount;
+	bool failed;
+	long long frameCount;
+
+	ThreadPool threads;
+	std::vector<Frame*> frames;
+	int pendingFrames;
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Scalar.h"
+
+// Size of the play area, shared by everything that moves in it
+#define RESOLUTION_X 800
+#define RESOLUTION_Y 600
+#define PI 3.14159265
+// Entities wrap around this far outside the screen
+#define SCREEN_MARGIN 10
+
+// If a coordinate goes outside the screen, it pops up on the other side
+inline Scalar WrapCoordinate(Scalar value, int limit)
+{
+	if (value < -SCREEN_MARGIN)
+	{
+		return limit + SCREEN_MARGIN;
+	}
+	if (value > limit + SCREEN_MARGIN)
+	{
+		return -SCREEN_MARGIN;
+	}
+	return value;
+}
+
+// Value between the last two simulation states; alpha goes from 0 (previous) to 1 (current)
+inline double Interpolate(double previous, double current, double alpha)
+{
+	return previous + (current - previous) * alpha;
+}